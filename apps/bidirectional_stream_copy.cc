@@ -16,8 +16,8 @@ void bidirectional_stream_copy( Socket& socket )
   EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
-  ByteStream _inbound { buffer_size };
+  ByteStream _outbound { buffer_size, ByteStream::Storage::Mirrored };
+  ByteStream _inbound { buffer_size, ByteStream::Storage::Mirrored };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
 
@@ -31,10 +31,7 @@ void bidirectional_stream_copy( Socket& socket )
     _input,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _outbound.writer().available_capacity() );
-      _input.read( data );
-      _outbound.writer().push( move( data ) );
+      _outbound.writer().commit( _input.read_into( _outbound.writer().reserve() ) );
       if ( _input.eof() ) {
         _outbound.writer().close();
       }
@@ -52,7 +49,7 @@ void bidirectional_stream_copy( Socket& socket )
     Direction::Out,
     [&] {
       if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
+        _outbound.reader().pop( socket.write( _outbound.reader().peek_all() ) );
       }
       if ( _outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
@@ -70,10 +67,7 @@ void bidirectional_stream_copy( Socket& socket )
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _inbound.writer().available_capacity() );
-      socket.read( data );
-      _inbound.writer().push( move( data ) );
+      _inbound.writer().commit( socket.read_into( _inbound.writer().reserve() ) );
       if ( socket.eof() ) {
         _inbound.writer().close();
       }
@@ -91,7 +85,7 @@ void bidirectional_stream_copy( Socket& socket )
     Direction::Out,
     [&] {
       if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
+        _inbound.reader().pop( _output.write( _inbound.reader().peek_all() ) );
       }
       if ( _inbound.reader().is_finished() ) {
         _output.close();
@@ -30,10 +30,16 @@ static void show_usage( const char* argv0, const char* msg )
        << "   -s <port>       Set source port (client mode only)              (random)\n\n"
 
        << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
-       << "\n\n"
+       << "\n"
+       << "   -W <maxwin>     Let the window auto-tune up to <maxwin> bytes   (fixed window)\n\n"
 
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+       << "   -m <mtu>        Set the link's MTU (9000 for jumbo frames)      " << FdAdapterConfig::DEFAULT_MTU
+       << "\n\n"
+
+       << "   -N              Coalesce small writes (Nagle's algorithm)       (send right away)\n\n"
+
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
@@ -88,11 +94,33 @@ static tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const sp
       c_fsm.recv_capacity = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-W", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -W requires one argument." );
+      c_fsm.recv_capacity_max = strtol( args[curr + 1], nullptr, 0 );
+      curr += 2;
+
     } else if ( strncmp( "-t", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-m", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -m requires one argument." );
+      const long mtu = strtol( args[curr + 1], nullptr, 0 );
+      if ( mtu < FdAdapterConfig::MIN_MTU or mtu > UINT16_MAX ) {
+        show_usage( args[0],
+                    ( "ERROR: -m requires an MTU from " + to_string( FdAdapterConfig::MIN_MTU ) + " to "
+                      + to_string( UINT16_MAX ) + "." )
+                      .c_str() );
+        exit( 1 );
+      }
+      c_filt.mtu = static_cast<uint16_t>( mtu );
+      curr += 2;
+
+    } else if ( strncmp( "-N", args[curr], 3 ) == 0 ) {
+      c_fsm.nodelay = false;
+      curr += 1;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
@@ -31,6 +31,9 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_direct)
+ttest(reassembler_slices)
+ttest(reassembler_bounded)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,7 +48,17 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
-
+ttest(recv_sack)
+ttest(recv_timestamps)
+ttest(tcp_segment_options)
+ttest(tcp_segmentation_offload)
+ttest(peer_window_scale)
+ttest(peer_delayed_ack)
+ttest(peer_timestamps)
+ttest(peer_autotune)
+ttest(socket_cork)
+
+ttest(send_buffer_range)
 ttest(send_connect)
 ttest(send_transmit)
 ttest(send_retx)
@@ -53,6 +66,16 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_rtt)
+ttest(send_recovery)
+ttest(send_sack)
+ttest(send_mss)
+ttest(send_offload)
+ttest(send_nagle)
+ttest(send_timestamps)
+ttest(send_rack_tlp)
+ttest(send_congestion)
+ttest(send_pacing)
 
 ttest(net_interface)
 
@@ -90,3 +113,5 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(reassembler_adversarial_speed_test)
+stest(sender_ack_speed_test)
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <climits>
 #include <cstdint>
 #include <stdexcept>
 
@@ -6,27 +7,246 @@
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), buffer_( capacity ) {}
+ByteStream::ByteStream( uint64_t capacity, Storage storage ) : capacity_( capacity ), storage_( storage ) {}
 
-void Writer::push( string data )
+void ByteStream::grow( uint64_t min_free )
+{
+  const auto needed = size_ + std::max( min_free, staged_ );
+  if ( needed <= ring_size() ) {
+    return;
+  }
+
+  const auto doubled = std::max( needed, 2 * ring_size() );
+  const auto chunks = ( doubled + ALLOCATION_CHUNK - 1 ) / ALLOCATION_CHUNK;
+  reallocate( std::min( capacity_, chunks * ALLOCATION_CHUNK ) );
+}
+
+void ByteStream::reallocate( uint64_t new_ring_size )
+{
+  if ( storage_ == Storage::Mirrored and new_ring_size > 0 ) {
+    try {
+      MirroredBuffer fresh { new_ring_size };
+      copy_ring_to( fresh.data() );
+      mirrored_ = std::move( fresh );
+      head_ = 0;
+      return;
+    } catch ( const exception& ) { // e.g. no memfd_create() in this sandbox: use the flat ring instead
+      storage_ = Storage::Flat;
+    }
+  }
+
+  vector<char> fresh( new_ring_size );
+  copy_ring_to( fresh.data() );
+  buffer_ = std::move( fresh );
+  mirrored_.reset();
+  head_ = 0;
+}
+
+void ByteStream::copy_ring_to( char* dest ) const
+{
+  // The buffered bytes, then any staged after them, in stream order
+  const auto len = size_ + staged_;
+  if ( len == 0 ) {
+    return;
+  }
+  const auto first_chunk = std::min( len, ring_size() - head_ );
+  std::copy_n( ring() + head_, first_chunk, dest );
+  std::copy_n( ring(), len - first_chunk, dest + first_chunk );
+}
+
+void ByteStream::shrink_to_fit()
+{
+  if ( storage_ == Storage::Rope ) {
+    rope_reserved_ = {};
+    return;
+  }
+
+  const auto chunks = ( size_ + staged_ + ALLOCATION_CHUNK - 1 ) / ALLOCATION_CHUNK;
+  const auto needed = chunks * ALLOCATION_CHUNK;
+  if ( needed < ring_size() ) {
+    reallocate( std::min( capacity_, needed ) );
+  }
+}
+
+void ByteStream::set_capacity( uint64_t capacity )
+{
+  const bool was_writable = writable();
+  capacity_ = std::max( capacity, size_ + staged_ );
+  notify_if_writability_changed( was_writable );
+}
+
+uint64_t ByteStream::memory_footprint() const
+{
+  if ( storage_ == Storage::Rope ) {
+    uint64_t total = rope_reserved_.capacity();
+    for ( const auto& piece : rope_ ) {
+      total += piece.size();
+    }
+    return total;
+  }
+  return mirrored_ ? mirrored_->size() : buffer_.capacity();
+}
+
+void ByteStream::notify_if_writability_changed( bool was_writable )
+{
+  if ( writable() != was_writable and writable_callback_ ) {
+    writable_callback_( writable() );
+  }
+}
+
+void Writer::push( string_view data )
 {
   if ( closed_ || error_ ) {
     return;
   }
-  
-  
-  auto len_to_write = std::min(data.length(), available_capacity());
-  if (len_to_write == 0) {
+
+  auto len_to_write = std::min( static_cast<uint64_t>( data.length() ), available_capacity() );
+  if ( len_to_write == 0 ) {
     return;
   }
-  auto tail = (head_ + size_) % capacity_;
-  auto first_chunk = std::min(len_to_write, capacity_ - tail);
-  std::copy_n(data.begin(), first_chunk, buffer_.begin() + static_cast<int64_t>(tail));
-  if (first_chunk < len_to_write) {
-    std::copy_n(data.begin() + static_cast<int64_t>(first_chunk), len_to_write - first_chunk, buffer_.begin());
+
+  const bool was_writable = writable();
+  if ( storage_ == Storage::Rope ) {
+    rope_.emplace_back( string { data.substr( 0, len_to_write ) } );
+  } else {
+    write_to_ring( data.substr( 0, len_to_write ) );
+    staged_ -= std::min( staged_, len_to_write );
   }
   size_ += len_to_write;
   bytes_pushed_ += len_to_write;
+  notify_if_writability_changed( was_writable );
+}
+
+void ByteStream::write_to_ring( string_view data, uint64_t offset )
+{
+  const auto len_to_write = static_cast<uint64_t>( data.size() );
+  grow( offset + len_to_write );
+  auto tail = ( head_ + size_ + offset ) % ring_size();
+  if ( mirrored_ ) {
+    std::copy_n( data.begin(), len_to_write, ring() + tail );
+  } else {
+    auto first_chunk = std::min( len_to_write, ring_size() - tail );
+    std::copy_n( data.begin(), first_chunk, ring() + tail );
+    if ( first_chunk < len_to_write ) {
+      std::copy_n( data.begin() + static_cast<int64_t>( first_chunk ), len_to_write - first_chunk, ring() );
+    }
+  }
+}
+
+void Writer::push( const string& data )
+{
+  push( string_view { data } );
+}
+
+void Writer::push( const Buffer& data )
+{
+  if ( storage_ != Storage::Rope ) {
+    push( static_cast<string_view>( data ) );
+    return;
+  }
+
+  if ( closed_ || error_ ) {
+    return;
+  }
+
+  auto len_to_write = std::min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  if ( len_to_write == 0 ) {
+    return;
+  }
+  const bool was_writable = writable();
+  rope_.push_back( len_to_write == data.size() ? data : data.slice( 0, len_to_write ) );
+  size_ += len_to_write;
+  bytes_pushed_ += len_to_write;
+  notify_if_writability_changed( was_writable );
+}
+
+vector<span<char>> Writer::reserve()
+{
+  vector<span<char>> regions;
+  const auto len = available_capacity();
+  if ( closed_ || error_ || len == 0 ) {
+    return regions;
+  }
+
+  if ( storage_ == Storage::Rope ) {
+    // Hand out a chunk, reusing the one reserved last time if it was never committed
+    if ( rope_reserved_.empty() ) {
+      rope_reserved_.resize( std::min( len, ALLOCATION_CHUNK ) );
+    }
+    regions.emplace_back( rope_reserved_.data(), std::min( len, static_cast<uint64_t>( rope_reserved_.size() ) ) );
+    return regions;
+  }
+
+  // Offer (at least) a chunk, growing geometrically while the writer keeps filling what it was given
+  grow( std::min( len, std::max( ALLOCATION_CHUNK, ring_size() ) ) );
+  const auto writable = std::min( len, ring_size() - size_ );
+  auto tail = ( head_ + size_ ) % ring_size();
+  if ( mirrored_ ) {
+    regions.emplace_back( ring() + tail, writable );
+    return regions;
+  }
+  auto first_chunk = std::min( writable, ring_size() - tail );
+  regions.emplace_back( ring() + tail, first_chunk );
+  if ( first_chunk < writable ) {
+    regions.emplace_back( ring(), writable - first_chunk );
+  }
+  return regions;
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( closed_ || error_ ) {
+    return;
+  }
+
+  auto len_to_commit = std::min( len, available_capacity() );
+  if ( storage_ == Storage::Rope ) {
+    len_to_commit = std::min( len_to_commit, static_cast<uint64_t>( rope_reserved_.size() ) );
+    if ( len_to_commit == 0 ) {
+      return;
+    }
+    rope_reserved_.resize( len_to_commit );
+    rope_.emplace_back( std::move( rope_reserved_ ) );
+    rope_reserved_.clear();
+  } else {
+    len_to_commit = std::min( len_to_commit, ring_size() - size_ );
+    staged_ -= std::min( staged_, len_to_commit );
+  }
+  const bool was_writable = writable();
+  size_ += len_to_commit;
+  bytes_pushed_ += len_to_commit;
+  notify_if_writability_changed( was_writable );
+}
+
+void Writer::stage( uint64_t offset, string_view data )
+{
+  if ( closed_ || error_ || storage_ == Storage::Rope ) {
+    return;
+  }
+
+  const auto room = capacity_ - size_;
+  if ( offset >= room ) {
+    return;
+  }
+  data = data.substr( 0, room - offset );
+  if ( data.empty() ) {
+    return;
+  }
+
+  write_to_ring( data, offset );
+  staged_ = std::max( staged_, offset + data.size() );
+}
+
+void Writer::set_low_watermark( uint64_t bytes )
+{
+  const bool was_writable = writable();
+  low_watermark_ = bytes;
+  notify_if_writability_changed( was_writable );
+}
+
+void Writer::set_writable_callback( function<void( bool )> callback )
+{
+  writable_callback_ = std::move( callback );
 }
 
 void Writer::close()
@@ -46,7 +266,7 @@ bool Writer::is_closed() const
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - size_;
+  return size_ < low_watermark_ ? capacity_ - size_ : 0;
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -56,9 +276,36 @@ uint64_t Writer::bytes_pushed() const
 
 string_view Reader::peek() const
 {
-  auto tail_bytes = std::min(size_, capacity_ - head_);
-  return {buffer_.data() + head_, tail_bytes};
+  if ( storage_ == Storage::Rope ) {
+    return rope_.empty() ? string_view {} : string_view { rope_.front() };
+  }
+  if ( mirrored_ ) {
+    return { ring() + head_, size_ };
+  }
+  auto tail_bytes = std::min( size_, ring_size() - head_ );
+  return { ring() + head_, tail_bytes };
+}
+
+vector<string_view> Reader::peek_all() const
+{
+  vector<string_view> views;
+  if ( size_ == 0 ) {
+    return views;
+  }
 
+  if ( storage_ == Storage::Rope ) {
+    // One view per piece, but no more than a single writev() accepts
+    const auto count = std::min( rope_.size(), static_cast<size_t>( IOV_MAX ) );
+    views.assign( rope_.begin(), rope_.begin() + static_cast<ptrdiff_t>( count ) );
+    return views;
+  }
+
+  const auto first = peek();
+  views.push_back( first );
+  if ( first.size() < size_ ) {
+    views.emplace_back( ring(), size_ - first.size() ); // the ring wrapped: rest starts at the front
+  }
+  return views;
 }
 
 bool Reader::is_finished() const
@@ -72,11 +319,62 @@ bool Reader::has_error() const
 }
 
 void Reader::pop( uint64_t len )
-{ 
-  auto len_to_pop = std::min(len, size_);
-  head_ = (head_ + len_to_pop) % capacity_;
+{
+  auto len_to_pop = std::min( len, size_ );
+  if ( len_to_pop == 0 ) {
+    return;
+  }
+
+  if ( storage_ == Storage::Rope ) {
+    for ( auto remaining = len_to_pop; remaining > 0; ) {
+      if ( rope_.front().size() <= remaining ) {
+        remaining -= rope_.front().size();
+        rope_.pop_front();
+      } else {
+        rope_.front() = rope_.front().slice( remaining );
+        remaining = 0;
+      }
+    }
+  } else {
+    head_ = ( head_ + len_to_pop ) % ring_size();
+  }
+  const bool was_writable = writable();
+  size_ -= len_to_pop;
+  bytes_popped_ += len_to_pop;
+  notify_if_writability_changed( was_writable );
+}
+
+vector<Buffer> Reader::pop_buffers( uint64_t len )
+{
+  vector<Buffer> out;
+  auto len_to_pop = std::min( len, size_ );
+  if ( len_to_pop == 0 ) {
+    return out;
+  }
+
+  if ( storage_ != Storage::Rope ) {
+    string data;
+    read( *this, len_to_pop, data );
+    out.emplace_back( std::move( data ) );
+    return out;
+  }
+
+  for ( auto remaining = len_to_pop; remaining > 0; ) {
+    if ( rope_.front().size() <= remaining ) {
+      remaining -= rope_.front().size();
+      out.push_back( std::move( rope_.front() ) );
+      rope_.pop_front();
+    } else {
+      out.push_back( rope_.front().slice( 0, remaining ) );
+      rope_.front() = rope_.front().slice( remaining );
+      remaining = 0;
+    }
+  }
+  const bool was_writable = writable();
   size_ -= len_to_pop;
   bytes_popped_ += len_to_pop;
+  notify_if_writability_changed( was_writable );
+  return out;
 }
 
 uint64_t Reader::bytes_buffered() const
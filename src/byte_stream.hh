@@ -1,6 +1,14 @@
 #pragma once
 
+#include "buffer.hh"
+#include "mirrored_buffer.hh"
+
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
 #include <queue>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -11,14 +19,46 @@ class Writer;
 
 class ByteStream
 {
+public:
+  // How the ByteStream lays out its buffered bytes
+  enum class Storage : uint8_t
+  {
+    Flat,     // A plain array of up to `capacity` bytes; peek() and push() split where the ring wraps
+    Mirrored, // Whole pages mapped twice back to back; peek() always sees every buffered byte at once
+    Rope,     // A queue of refcounted Buffers; push( Buffer ) and pop_buffers() share bytes instead of copying
+  };
+
 protected:
   uint64_t capacity_;
+  Storage storage_ { Storage::Flat }; // The storage actually in use (Mirrored may have fallen back to Flat)
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   // std::string buffer_;
-  std::vector<char> buffer_;
+  std::vector<char> buffer_ {};               // Ring storage in Flat mode (allocated as data arrives)
+  std::optional<MirroredBuffer> mirrored_ {}; // Ring storage in Mirrored mode (likewise)
+  std::deque<Buffer> rope_ {};                // Buffered slices in Rope mode, oldest first
+  std::string rope_reserved_ {};              // Rope mode: scratch space handed out by Writer::reserve()
   uint64_t head_{0};  // Index of first byte to read
   uint64_t size_{0};  // Number of bytes currently in buffer
+  uint64_t staged_{0}; // Extent past the buffered bytes that may hold staged (not yet readable) data
+
+  char* ring() { return mirrored_ ? mirrored_->data() : buffer_.data(); }
+  const char* ring() const { return mirrored_ ? mirrored_->data() : buffer_.data(); }
+  uint64_t ring_size() const { return mirrored_ ? mirrored_->size() : buffer_.size(); }
 
+  // The ring is allocated lazily and grows (at least doubling, in whole chunks, up to capacity) on demand
+  static constexpr uint64_t ALLOCATION_CHUNK = 4096;
+  void grow( uint64_t min_free );            // Make room in the ring for at least `min_free` more bytes
+  void reallocate( uint64_t new_ring_size ); // Move the buffered (and staged) bytes to the front of a new ring
+  void copy_ring_to( char* dest ) const;     // Copy the buffered and staged bytes, in order, to `dest`
+
+  // Copy `data` into the ring, `offset` bytes past the end of the buffered bytes
+  void write_to_ring( std::string_view data, uint64_t offset = 0 );
+
+  // Writer readiness: capacity is only offered while fewer than `low_watermark_` bytes are buffered
+  uint64_t low_watermark_ { std::numeric_limits<uint64_t>::max() };
+  std::function<void( bool )> writable_callback_ {}; // Told when the Writer gains or loses available capacity
+  bool writable() const { return size_ < capacity_ and size_ < low_watermark_; }
+  void notify_if_writability_changed( bool was_writable );
 
   bool closed_{false};
   bool error_{false};
@@ -26,7 +66,18 @@ protected:
   uint64_t bytes_popped_{0};
 
 public:
-  explicit ByteStream( uint64_t capacity );
+  // Mirrored storage falls back to Flat if the pages can't be mapped
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Flat );
+
+  Storage storage() const { return storage_; }
+
+  // Capacity is a limit, not an allocation: storage is obtained as bytes arrive, and handed back here
+  void shrink_to_fit();              // Release storage beyond what the buffered bytes need (all of it, if none)
+  uint64_t memory_footprint() const; // Bytes of storage currently held by the stream
+
+  // The capacity can change over the stream's life, but never drops below what is buffered (and staged)
+  uint64_t capacity() const { return capacity_; }
+  void set_capacity( uint64_t capacity );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -38,7 +89,28 @@ public:
 class Writer : public ByteStream
 {
 public:
-  void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+  void push( std::string_view data );   // Push data to stream, but only as much as available capacity allows.
+  void push( const std::string& data ); // Same, for a string owned by the caller (copied once, into the stream).
+  void push( const Buffer& data );      // Same, for a Buffer (shared, not copied, by a Rope stream).
+
+  // Zero-copy alternative to push(): fill the regions returned by reserve() (at most two, in order, covering
+  // as much of the available capacity as is allocated -- at least a chunk), then commit() how many bytes were
+  // written. Any other call invalidates them.
+  std::vector<std::span<char>> reserve();
+  void commit( uint64_t len );
+
+  // Copy `data` into the free space `offset` bytes past the end of the buffered bytes (as far as capacity
+  // allows) without making it readable; commit() publishes it once everything before it is in place. Staged
+  // bytes survive the ring growing, but push() and reserve() may overwrite them. Not supported by a Rope.
+  void stage( uint64_t offset, std::string_view data );
+
+  // Like TCP_NOTSENT_LOWAT: report no available capacity once `bytes` or more are buffered, and report it again
+  // (all of it) only when the buffered bytes drop below that mark
+  void set_low_watermark( uint64_t bytes );
+
+  // `callback( false )` runs when available capacity drops to zero (the stream filled or reached its low
+  // watermark); `callback( true )` runs when it becomes nonzero again
+  void set_writable_callback( std::function<void( bool )> callback );
 
   void close();     // Signal that the stream has reached its ending. Nothing more will be written.
   void set_error(); // Signal that the stream suffered an error.
@@ -51,8 +123,14 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
-  void pop( uint64_t len );      // Remove `len` bytes from the buffer
+  std::string_view peek() const;                  // Peek at the next bytes in the buffer
+  std::vector<std::string_view> peek_all() const; // Peek at every buffered byte (in order; at most two views,
+                                                  // or for a Rope at most IOV_MAX, so possibly not every byte)
+  void pop( uint64_t len );                       // Remove `len` bytes from the buffer
+
+  // Remove up to `len` bytes from the buffer and return them. A Rope stream hands back slices of the Buffers
+  // that were pushed, without copying; other streams copy the bytes into one new Buffer.
+  std::vector<Buffer> pop_buffers( uint64_t len );
 
   bool is_finished() const; // Is the stream finished (closed and fully popped)?
   bool has_error() const;   // Has the stream had an error?
@@ -0,0 +1,302 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+class NoCongestionControl : public CongestionController
+{
+public:
+  uint64_t cwnd() const override { return numeric_limits<uint64_t>::max(); }
+  uint64_t ssthresh() const override { return numeric_limits<uint64_t>::max(); }
+
+  void on_ack( uint64_t /* bytes_acked */, uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ ) override {}
+  void on_loss( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ ) override {}
+  void on_rto( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ ) override {}
+};
+
+} // namespace
+
+unique_ptr<CongestionController> CongestionController::make( CongestionControl algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case CongestionControl::NewReno:
+      return make_unique<NewReno>( mss );
+    case CongestionControl::Cubic:
+      return make_unique<Cubic>( mss );
+    case CongestionControl::Bbr:
+      return make_unique<Bbr>( mss );
+    default:
+      return make_unique<NoCongestionControl>();
+  }
+}
+
+namespace {
+
+// Initial window from RFC 6928
+uint64_t initial_window( uint64_t mss )
+{
+  return min( 10 * mss, max( 2 * mss, uint64_t { 14600 } ) );
+}
+
+} // namespace
+
+NewReno::NewReno( uint64_t mss )
+  : mss_( mss )
+  , cwnd_( initial_window( mss ) )
+  , ssthresh_( numeric_limits<uint64_t>::max() )
+{}
+
+void NewReno::on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  // Only grow a window that is actually being used (RFC 7661)
+  if ( cwnd_ < ssthresh_ ) {
+    if ( bytes_in_flight * 2 >= cwnd_ ) {
+      cwnd_ += min( bytes_acked, mss_ );
+    }
+    return;
+  }
+
+  if ( bytes_in_flight + mss_ < cwnd_ ) {
+    return;
+  }
+  bytes_acked_in_avoidance_ += bytes_acked;
+  if ( bytes_acked_in_avoidance_ >= cwnd_ ) {
+    bytes_acked_in_avoidance_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::enter_loss_recovery( uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_in_avoidance_ = 0;
+}
+
+void NewReno::on_loss( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  enter_loss_recovery( bytes_in_flight );
+}
+
+void NewReno::on_rto( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  enter_loss_recovery( bytes_in_flight );
+  cwnd_ = mss_;
+}
+
+void Cubic::reduce()
+{
+  const double segments = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+
+  // Fast convergence: if the window stopped short of the last maximum, another flow is probably starting
+  // up, so give some of the headroom back
+  w_max_ = segments < w_last_max_ ? segments * ( 1 + BETA ) / 2 : segments;
+  w_last_max_ = segments;
+
+  ssthresh_ = max( static_cast<uint64_t>( llround( static_cast<double>( cwnd_ ) * BETA ) ), 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_in_avoidance_ = 0;
+  in_epoch_ = false;
+}
+
+void Cubic::on_loss( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+}
+
+void Cubic::on_rto( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = mss_;
+}
+
+void Cubic::on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  if ( cwnd_ < ssthresh_ ) {
+    NewReno::on_ack( bytes_acked, bytes_in_flight, now_ms );
+    return;
+  }
+  if ( bytes_in_flight + mss_ < cwnd_ ) {
+    return;
+  }
+
+  const double mss = static_cast<double>( mss_ );
+  const double segments = static_cast<double>( cwnd_ ) / mss;
+  if ( not in_epoch_ ) {
+    in_epoch_ = true;
+    epoch_start_ms_ = now_ms;
+    w_est_ = segments;
+    if ( w_max_ <= segments ) {
+      w_max_ = segments;
+      k_ = 0;
+    } else {
+      k_ = cbrt( ( w_max_ - segments ) / C );
+    }
+  }
+
+  // Where the cubic curve says the window should be, allowing at most 1.5x growth per round trip
+  const double t = static_cast<double>( now_ms - epoch_start_ms_ ) / 1000.0;
+  double target = std::clamp( C * pow( t - k_, 3 ) + w_max_, segments, 1.5 * segments );
+
+  // Never grow more slowly than Reno would have from the same starting point
+  const double segments_acked = static_cast<double>( bytes_acked ) / mss;
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * segments_acked / segments;
+  target = max( target, w_est_ );
+
+  const double next = segments + ( target - segments ) / segments * segments_acked;
+  cwnd_ = max( cwnd_, static_cast<uint64_t>( next * mss ) );
+}
+
+// Until there is a bandwidth estimate, pace the initial window out over one (nominal) millisecond
+Bbr::Bbr( uint64_t mss )
+  : mss_( mss ), cwnd_( initial_window( mss ) ), pacing_rate_( HIGH_GAIN * static_cast<double>( cwnd_ ) )
+{}
+
+uint64_t Bbr::cwnd() const
+{
+  return mode_ == Mode::ProbeRTT ? min( cwnd_, MIN_CWND_SEGMENTS * mss_ ) : cwnd_;
+}
+
+uint64_t Bbr::ssthresh() const
+{
+  return numeric_limits<uint64_t>::max();
+}
+
+optional<double> Bbr::pacing_rate() const
+{
+  return pacing_rate_;
+}
+
+void Bbr::update_pacing_rate()
+{
+  // Early samples (like the handshake's) say little about the path, so in Startup the rate only goes up
+  const double rate = pacing_gain_ * bandwidth();
+  if ( rate > 0 and ( filled_pipe_ or rate > pacing_rate_ ) ) {
+    pacing_rate_ = rate;
+  }
+}
+
+uint64_t Bbr::bdp( double gain ) const
+{
+  if ( not min_rtt_ms_.has_value() or bandwidth() == 0 ) {
+    return initial_window( mss_ );
+  }
+  return static_cast<uint64_t>( gain * bandwidth() * static_cast<double>( min_rtt_ms_.value() ) );
+}
+
+void Bbr::enter_probe_bw( uint64_t now_ms )
+{
+  mode_ = Mode::ProbeBW;
+  cwnd_gain_ = CWND_GAIN;
+  cycle_index_ = 2; // Start cruising; the probing phases come round soon enough
+  pacing_gain_ = PROBE_BW_GAINS[cycle_index_];
+  cycle_stamp_ms_ = now_ms;
+}
+
+void Bbr::on_rate_sample( const RateSample& sample, uint64_t now_ms )
+{
+  // A round trip ends when a segment sent after the previous one ended is acknowledged
+  round_start_ = sample.prior_delivered >= next_round_delivered_;
+  if ( round_start_ ) {
+    next_round_delivered_ = sample.delivered;
+    ++round_count_;
+  }
+
+  // Windowed maximum (a monotonic queue); an application-limited sample can only raise the estimate
+  if ( not sample.app_limited or sample.delivery_rate >= bandwidth() ) {
+    while ( not bw_samples_.empty() and bw_samples_.back().second <= sample.delivery_rate ) {
+      bw_samples_.pop_back();
+    }
+    bw_samples_.emplace_back( round_count_, sample.delivery_rate );
+  }
+  while ( bw_samples_.size() > 1 and bw_samples_.front().first + BW_WINDOW_ROUNDS <= round_count_ ) {
+    bw_samples_.pop_front();
+  }
+
+  // The clock resolution is a millisecond, so that's the shortest round trip we can measure
+  const uint64_t rtt = max( sample.rtt_ms, uint64_t { 1 } );
+  min_rtt_expired_ = min_rtt_ms_.has_value() and now_ms > min_rtt_stamp_ms_ + MIN_RTT_WINDOW_MS;
+  if ( not min_rtt_ms_.has_value() or rtt <= min_rtt_ms_.value() or min_rtt_expired_ ) {
+    min_rtt_ms_ = rtt;
+    min_rtt_stamp_ms_ = now_ms;
+  }
+
+  if ( not filled_pipe_ and round_start_ and not sample.app_limited ) {
+    if ( bandwidth() >= full_bw_ * 1.25 ) {
+      full_bw_ = bandwidth();
+      full_bw_rounds_ = 0;
+    } else if ( ++full_bw_rounds_ >= 3 ) {
+      filled_pipe_ = true;
+    }
+  }
+}
+
+void Bbr::on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  const uint64_t in_flight = bytes_in_flight - min( bytes_in_flight, bytes_acked );
+
+  if ( mode_ == Mode::Startup and filled_pipe_ ) {
+    mode_ = Mode::Drain;
+    pacing_gain_ = DRAIN_GAIN;
+  }
+  if ( mode_ == Mode::Drain and in_flight <= bdp( 1 ) ) {
+    enter_probe_bw( now_ms );
+  }
+  if ( mode_ == Mode::ProbeBW and now_ms - cycle_stamp_ms_ > min_rtt_ms_.value_or( 0 ) ) {
+    cycle_index_ = ( cycle_index_ + 1 ) % size( PROBE_BW_GAINS );
+    pacing_gain_ = PROBE_BW_GAINS[cycle_index_];
+    cycle_stamp_ms_ = now_ms;
+  }
+
+  if ( mode_ != Mode::ProbeRTT and min_rtt_expired_ ) {
+    mode_ = Mode::ProbeRTT;
+    pacing_gain_ = 1;
+    cwnd_gain_ = 1;
+    probe_rtt_done_ms_ = now_ms + PROBE_RTT_DURATION_MS;
+    min_rtt_expired_ = false;
+  }
+  if ( mode_ == Mode::ProbeRTT and now_ms >= probe_rtt_done_ms_ ) {
+    min_rtt_stamp_ms_ = now_ms;
+    if ( filled_pipe_ ) {
+      enter_probe_bw( now_ms );
+    } else {
+      mode_ = Mode::Startup;
+      pacing_gain_ = cwnd_gain_ = HIGH_GAIN;
+    }
+  }
+
+  // Once acks flow again after a loss or timeout, go back to the window from before it
+  if ( prior_cwnd_ > 0 ) {
+    cwnd_ = max( cwnd_, prior_cwnd_ );
+    prior_cwnd_ = 0;
+  }
+
+  // Grow towards a couple of bandwidth-delay products (in Startup, without clamping to the target)
+  const uint64_t target = max( bdp( cwnd_gain_ ), MIN_CWND_SEGMENTS * mss_ );
+  if ( filled_pipe_ ) {
+    cwnd_ = min( cwnd_ + bytes_acked, target );
+  } else if ( cwnd_ < target ) {
+    cwnd_ += bytes_acked;
+  }
+  cwnd_ = max( cwnd_, MIN_CWND_SEGMENTS * mss_ );
+
+  update_pacing_rate();
+}
+
+void Bbr::on_loss( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  // Loss isn't the signal BBR steers by: just stop sending more than is getting through until it's repaired
+  prior_cwnd_ = max( prior_cwnd_, cwnd_ );
+  cwnd_ = max( bytes_in_flight, MIN_CWND_SEGMENTS * mss_ );
+}
+
+void Bbr::on_rto( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  prior_cwnd_ = max( prior_cwnd_, cwnd_ );
+  cwnd_ = mss_;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+
+// Which congestion control algorithm a TCPSender runs
+enum class CongestionControl : uint8_t
+{
+  None,    // Only the receiver's window limits what is in flight
+  NewReno, // RFC 5681 slow start and congestion avoidance
+  Cubic,   // RFC 9438
+  Bbr      // Model-based (bottleneck bandwidth and round-trip time), with pacing
+};
+
+// What one acknowledgment says about the path: how fast data was delivered, and how long it took
+struct RateSample
+{
+  double delivery_rate {};        // Bytes per millisecond, over the interval the acked segment was in flight
+  uint64_t rtt_ms {};             // Round-trip time of the most recently sent segment that was acked
+  uint64_t prior_delivered {};    // Bytes delivered when that segment was sent
+  uint64_t delivered {};          // Bytes delivered now
+  bool app_limited {};            // The sender ran out of data while that segment was in flight
+};
+
+/*
+ * A CongestionController decides how many sequence numbers the TCPSender may have in flight (the
+ * congestion window, "cwnd"). The sender tells it about every acknowledgment of new data, every loss
+ * detected by other means than the retransmission timer, and every retransmission timeout.
+ *
+ * All sizes are in bytes (sequence numbers); all times are in milliseconds on the sender's clock.
+ */
+class CongestionController
+{
+public:
+  virtual ~CongestionController() = default;
+
+  static std::unique_ptr<CongestionController> make( CongestionControl algorithm, uint64_t mss );
+
+  virtual uint64_t cwnd() const = 0;
+  virtual uint64_t ssthresh() const = 0;
+
+  // Bytes per millisecond to space transmissions out at, if this algorithm paces them
+  virtual std::optional<double> pacing_rate() const { return {}; }
+
+  // Called before on_ack() whenever the acknowledgment yields a usable delivery-rate sample
+  virtual void on_rate_sample( const RateSample& /* sample */, uint64_t /* now_ms */ ) {}
+
+  // `bytes_acked` new sequence numbers were acknowledged; `bytes_in_flight` were outstanding before the ack
+  virtual void on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms ) = 0;
+
+  // A loss was detected without waiting for the retransmission timer
+  virtual void on_loss( uint64_t bytes_in_flight, uint64_t now_ms ) = 0;
+
+  // The retransmission timer expired (only the first expiry of a run of back-to-back timeouts is reported)
+  virtual void on_rto( uint64_t bytes_in_flight, uint64_t now_ms ) = 0;
+};
+
+// Slow start and congestion avoidance (RFC 5681), with appropriate byte counting (RFC 3465, L = 1 MSS)
+class NewReno : public CongestionController
+{
+protected:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_;
+  uint64_t bytes_acked_in_avoidance_ {}; // Acked bytes not yet turned into window growth
+
+  void enter_loss_recovery( uint64_t bytes_in_flight );
+
+public:
+  explicit NewReno( uint64_t mss );
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const override { return ssthresh_; }
+
+  void on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+};
+
+// CUBIC (RFC 9438): after a loss, the window follows a cubic function of the time since that loss, rising
+// quickly back towards the window where the loss happened, flattening out near it, and then probing beyond
+class Cubic : public NewReno
+{
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  double w_max_ {};            // Window (in segments) just before the last reduction
+  double w_last_max_ {};       // w_max_ before that, for fast convergence
+  double w_est_ {};            // Reno-friendly estimate of the window, in segments
+  double k_ {};                // Seconds from the start of the epoch until the curve reaches w_max_
+  uint64_t epoch_start_ms_ {}; // When the current congestion-avoidance epoch began
+  bool in_epoch_ {};
+
+  void reduce();
+
+public:
+  using NewReno::NewReno;
+
+  void on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+};
+
+// BBR: rather than treating loss as the signal of congestion, build a model of the path from delivery-rate
+// samples (the bottleneck bandwidth is the largest recent delivery rate, the propagation delay the smallest
+// recent round-trip time), pace transmissions at about the bottleneck bandwidth, and keep about one
+// bandwidth-delay product in flight
+class Bbr : public CongestionController
+{
+  enum class Mode : uint8_t
+  {
+    Startup,  // Double the sending rate each round trip until the bandwidth stops growing
+    Drain,    // Drain the queue Startup built up
+    ProbeBW,  // Cruise at the estimated bandwidth, periodically probing for more
+    ProbeRTT  // Briefly shrink the window to re-measure the propagation delay
+  };
+
+  static constexpr double HIGH_GAIN = 2.885; // 2/ln(2): doubles the rate each round trip
+  static constexpr double DRAIN_GAIN = 1 / HIGH_GAIN;
+  static constexpr double CWND_GAIN = 2;
+  static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+  static constexpr uint64_t PROBE_RTT_DURATION_MS = 200;
+  static constexpr uint64_t MIN_CWND_SEGMENTS = 4;
+  static constexpr double PROBE_BW_GAINS[] = { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+
+  uint64_t mss_;
+  uint64_t cwnd_;
+  double pacing_rate_;
+  Mode mode_ { Mode::Startup };
+  double pacing_gain_ { HIGH_GAIN };
+  double cwnd_gain_ { HIGH_GAIN };
+
+  // Bottleneck bandwidth: running maximum of (round, delivery rate) samples over the last BW_WINDOW_ROUNDS
+  std::deque<std::pair<uint64_t, double>> bw_samples_ {};
+  uint64_t round_count_ {};
+  uint64_t next_round_delivered_ {};
+  bool round_start_ {};
+
+  // Propagation delay: smallest round-trip time seen in the last MIN_RTT_WINDOW_MS
+  std::optional<uint64_t> min_rtt_ms_ {};
+  uint64_t min_rtt_stamp_ms_ {};
+
+  // Startup ends once three rounds in a row fail to raise the bandwidth by a quarter
+  double full_bw_ {};
+  uint64_t full_bw_rounds_ {};
+  bool filled_pipe_ {};
+
+  size_t cycle_index_ {};
+  uint64_t cycle_stamp_ms_ {};
+  uint64_t probe_rtt_done_ms_ {};
+  uint64_t prior_cwnd_ {}; // Window to go back to once a loss or timeout has been recovered from
+  bool min_rtt_expired_ {};
+
+  double bandwidth() const { return bw_samples_.empty() ? 0 : bw_samples_.front().second; }
+  uint64_t bdp( double gain ) const;
+  void enter_probe_bw( uint64_t now_ms );
+  void update_pacing_rate();
+
+public:
+  explicit Bbr( uint64_t mss );
+
+  uint64_t cwnd() const override;
+  uint64_t ssthresh() const override;
+  std::optional<double> pacing_rate() const override;
+
+  void on_rate_sample( const RateSample& sample, uint64_t now_ms ) override;
+  void on_ack( uint64_t bytes_acked, uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+};
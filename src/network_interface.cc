@@ -7,8 +7,9 @@ using namespace std;
 
 // ethernet_address: Ethernet (what ARP calls "hardware") address of the interface
 // ip_address: IP (what ARP calls "protocol") address of the interface
-NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address )
-  : ethernet_address_( ethernet_address ), ip_address_( ip_address )
+// mtu: the largest datagram the link carries
+NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address, size_t mtu )
+  : ethernet_address_( ethernet_address ), ip_address_( ip_address ), mtu_( mtu )
 {
   cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ ) << " and IP address "
        << ip_address.ip() << "\n";
@@ -22,6 +23,16 @@ NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, con
 // Address::ipv4_numeric() method.
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
+  // A datagram too big for the link is dropped, as if it had the Don't Fragment bit set
+  size_t length = dgram.header.hlen * 4UL;
+  for ( const auto& piece : dgram.payload ) {
+    length += piece.size();
+  }
+  if ( length > mtu_ ) {
+    cerr << "DEBUG: Dropping a " << length << "-byte datagram, larger than the MTU (" << mtu_ << ")\n";
+    return;
+  }
+
   uint32_t next_hop_ip = next_hop.ipv4_numeric();
 
   // Check if we already know the Ethernet address for this IP
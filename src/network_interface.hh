@@ -42,28 +42,36 @@ private:
   Address ip_address_;
 
   // ARP cache: maps IP address to (Ethernet address, timestamp)
-  std::unordered_map<uint32_t, std::pair<EthernetAddress, size_t>> arp_cache_;
+  std::unordered_map<uint32_t, std::pair<EthernetAddress, size_t>> arp_cache_ {};
 
   // Pending ARP requests: maps IP address to timestamp of last request
-  std::unordered_map<uint32_t, size_t> pending_arp_requests_;
+  std::unordered_map<uint32_t, size_t> pending_arp_requests_ {};
 
   // Queue of Ethernet frames waiting to be sent
-  std::queue<EthernetFrame> frames_to_send_;
+  std::queue<EthernetFrame> frames_to_send_ {};
 
   // Queue of datagrams waiting for ARP resolution: maps IP address to list of datagrams
-  std::unordered_map<uint32_t, std::queue<InternetDatagram>> pending_datagrams_;
+  std::unordered_map<uint32_t, std::queue<InternetDatagram>> pending_datagrams_ {};
 
   // Current time in milliseconds
   size_t current_time_ms_ = 0;
 
+  // Largest datagram the link carries (there's no fragmentation, so bigger ones are dropped)
+  size_t mtu_;
+
   // Constants
   static constexpr size_t ARP_CACHE_TIMEOUT_MS = 30000; // 30 seconds
   static constexpr size_t ARP_REQUEST_TIMEOUT_MS = 5000; // 5 seconds
 
 public:
+  static constexpr size_t DEFAULT_MTU = 1500; // Ethernet's (jumbo frames carry up to 9000)
+
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
-  // addresses
-  NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address );
+  // addresses, and the link's MTU
+  NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address, size_t mtu = DEFAULT_MTU );
+
+  size_t mtu() const { return mtu_; }
+  void set_mtu( size_t mtu ) { mtu_ = mtu; }
 
   // Access queue of Ethernet frames awaiting transmission
   std::optional<EthernetFrame> maybe_send();
@@ -1,144 +1,214 @@
 #include "reassembler.hh"
 #include <algorithm>
-#include <vector>
 
 using namespace std;
 
+namespace {
+
+uint64_t end_of( const pair<const uint64_t, Buffer>& substring )
+{
+  return substring.first + substring.second.size();
+}
+
+uint64_t end_of( const pair<const uint64_t, uint64_t>& interval )
+{
+  return interval.second;
+}
+
+// Pieces held in either map may abut (buffered slices often do), so ranges are merged across them
+template<class Map>
+optional<pair<uint64_t, uint64_t>> merged_range_containing( const Map& pieces, uint64_t index )
+{
+  auto it = pieces.upper_bound( index );
+  if ( it == pieces.begin() || end_of( *prev( it ) ) <= index ) {
+    return {};
+  }
+  --it;
+  auto first = it;
+  while ( first != pieces.begin() && end_of( *prev( first ) ) == first->first ) {
+    --first;
+  }
+  uint64_t last = end_of( *it );
+  for ( ++it; it != pieces.end() && it->first == last; ++it ) {
+    last = end_of( *it );
+  }
+  return pair { first->first, last };
+}
+
+template<class Map>
+vector<pair<uint64_t, uint64_t>> merged_ranges( const Map& pieces, size_t max_ranges )
+{
+  vector<pair<uint64_t, uint64_t>> result;
+  for ( const auto& piece : pieces ) {
+    if ( !result.empty() && result.back().second == piece.first ) {
+      result.back().second = end_of( piece );
+    } else if ( result.size() < max_ranges ) {
+      result.emplace_back( piece.first, end_of( piece ) );
+    } else {
+      break;
+    }
+  }
+  return result;
+}
+
+} // namespace
+
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
+{
+  insert( first_index, Buffer { std::move( data ) }, is_last_substring, output );
+}
+
+void Reassembler::insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output )
 { // Handle the last substring flag
   if ( is_last_substring ) {
     is_last_substring_received_ = true;
     stream_end_index_ = first_index + data.size();
   }
 
-  // If the data starts beyond our capacity window, discard it entirely
-  uint64_t max_acceptable_index = next_expected_index_ + output.available_capacity();
+  if ( placement_ == Placement::Direct && output.storage() != ByteStream::Storage::Rope ) {
+    insert_direct( first_index, data, output );
+  } else {
+    insert_buffered( first_index, data, output );
+  }
 
-  // Trim data that extends beyond our capacity window
-  uint64_t last_index = first_index + data.size();
-  if ( last_index > max_acceptable_index ) {
-    data = data.substr( 0, max_acceptable_index - first_index );
-    last_index = max_acceptable_index;
+  // Check if we should close the stream
+  if ( is_last_substring_received_ && next_expected_index_ >= stream_end_index_ ) {
+    output.close();
   }
+}
 
-  // If the data ends before our next expected index, it's all redundant
-  if ( last_index <= next_expected_index_ ) {
-    // Check if we should close the stream
-    if ( is_last_substring_received_ && next_expected_index_ >= stream_end_index_ ) {
-      output.close();
-    }
+void Reassembler::insert_buffered( uint64_t first_index, const Buffer& data, Writer& output )
+{
+  // Keep only the part of the substring inside the window [next_expected_index_, + available capacity)
+  const uint64_t window_end = next_expected_index_ + output.available_capacity();
+  const uint64_t start = std::max( first_index, next_expected_index_ );
+  const uint64_t end = std::min( first_index + data.size(), window_end );
+  if ( start >= end ) {
     return;
   }
 
-  // Trim redundant prefix (data that we've already processed)
-  if ( first_index < next_expected_index_ ) {
-    uint64_t trim_amount = next_expected_index_ - first_index;
-    data = data.substr( trim_amount );
-    first_index = next_expected_index_;
+  // Store slices of the new data covering only the bytes no stored substring already has
+  auto it = unassembled_substrings_.upper_bound( start );
+  if ( it != unassembled_substrings_.begin() ) {
+    const auto before = std::prev( it );
+    if ( before->first + before->second.size() > start ) {
+      it = before;
+    }
+  }
+  uint64_t cursor = start;
+  while ( cursor < end ) {
+    if ( it == unassembled_substrings_.end() || it->first >= end ) {
+      store_buffered( it, cursor, data.slice( cursor - first_index, end - cursor ) );
+      break;
+    }
+    if ( it->first > cursor ) {
+      store_buffered( it, cursor, data.slice( cursor - first_index, it->first - cursor ) );
+    }
+    cursor = std::max( cursor, it->first + it->second.size() );
+    ++it;
   }
 
-  // Now we have data that's at least partially useful
-  // We need to merge it with existing unassembled substrings to avoid storing overlaps
+  // Write whatever is now contiguous with the bytes already written
+  while ( !unassembled_substrings_.empty() && unassembled_substrings_.begin()->first == next_expected_index_ ) {
+    const auto front = unassembled_substrings_.begin();
+    output.push( front->second );
+    next_expected_index_ += front->second.size();
+    erase_buffered( front );
+  }
 
-  // Find overlapping and adjacent ranges and merge them
-  auto insert_start = first_index;
-  auto insert_end = first_index + data.size();
-  string merged_data = data;
+  evict_excess_intervals();
+}
 
-  // Find the range of existing substrings that overlap or are adjacent to our new data
-  auto it_start = unassembled_substrings_.lower_bound( insert_start );
-  if ( it_start != unassembled_substrings_.begin() ) {
-    --it_start;
-    // Check if this segment overlaps or is adjacent
-    uint64_t seg_start = it_start->first;
-    uint64_t seg_end = seg_start + it_start->second.size();
-    if ( seg_end < insert_start ) {
-      ++it_start; // No overlap or adjacency
-    }
+void Reassembler::insert_direct( uint64_t first_index, string_view data, Writer& output )
+{
+  // Keep only the part of the substring inside the window [next_expected_index_, + available capacity)
+  const uint64_t window_end = next_expected_index_ + output.available_capacity();
+  uint64_t start = std::max( first_index, next_expected_index_ );
+  uint64_t end = std::min( first_index + data.size(), window_end );
+  if ( start >= end ) {
+    return;
   }
+  data = data.substr( start - first_index, end - start );
+
+  // Copy the bytes into place; overlaps with what is already staged rewrite identical bytes
+  output.stage( start - next_expected_index_, data );
 
-  // Include segments that start at or before insert_end (to catch adjacent segments)
-  auto it_end = unassembled_substrings_.upper_bound( insert_end );
-
-  // Collect all overlapping/adjacent segments plus the new data
-  struct Segment {
-    uint64_t start;
-    uint64_t end;
-    string data;
-  };
-  
-  vector<Segment> segments;
-  segments.push_back( { insert_start, insert_end, merged_data } );
-  
-  for ( auto it = it_start; it != it_end; ++it ) {
-    uint64_t seg_start = it->first;
-    uint64_t seg_end = seg_start + it->second.size();
-    segments.push_back( { seg_start, seg_end, it->second } );
-  }
-  
-  // Sort segments by start position
-  std::ranges::sort( segments, []( const Segment& a, const Segment& b ) {
-    return a.start < b.start;
-  } );
-  
-  // Find the overall range
-  uint64_t final_start = segments[0].start;
-  uint64_t final_end = segments[0].end;
-  for ( const auto& seg : segments ) {
-    final_end = std::max( final_end, seg.end );
-  }
-  
-  // Build the final merged data
-  string final_data;
-  final_data.resize( final_end - final_start );
-  
-  // Copy data from each segment to the appropriate position
-  for ( const auto& seg : segments ) {
-    uint64_t offset = seg.start - final_start;
-    std::ranges::copy( seg.data, final_data.begin() + static_cast<ptrdiff_t>( offset ) );
-  }
-  
-  merged_data = std::move( final_data );
-  insert_start = final_start;
-  insert_end = final_end;
-
-  // Remove the overlapping segments
-  unassembled_substrings_.erase( it_start, it_end );
-
-  // Try to write immediately if this data starts at our next expected index
-  if ( insert_start == next_expected_index_ ) {
-    // Write as much as we can
-    output.push( merged_data );
-    next_expected_index_ += merged_data.size();
-
-    // Check if we can write more from stored segments
-    while ( !unassembled_substrings_.empty() ) {
-      auto it = unassembled_substrings_.begin();
-      if ( it->first == next_expected_index_ ) {
-        // This segment is next in sequence
-        output.push( it->second );
-        next_expected_index_ += it->second.size();
-        unassembled_substrings_.erase( it );
-      } else {
-        break; // There's a gap
-      }
+  // Merge [start, end) with every staged interval it overlaps or touches, counting only new bytes
+  uint64_t newly_covered = end - start;
+  auto it = staged_intervals_.upper_bound( start );
+  if ( it != staged_intervals_.begin() && std::prev( it )->second >= start ) {
+    --it;
+  }
+  while ( it != staged_intervals_.end() && it->first <= end ) {
+    const auto overlap_start = std::max( start, it->first );
+    const auto overlap_end = std::min( end, it->second );
+    if ( overlap_end > overlap_start ) {
+      newly_covered -= overlap_end - overlap_start;
     }
-  } else {
-    // Store the merged data for later
-    unassembled_substrings_[insert_start] = merged_data;
+    start = std::min( start, it->first );
+    end = std::max( end, it->second );
+    it = staged_intervals_.erase( it );
   }
-
-  // Check if we should close the stream
-  if ( is_last_substring_received_ && next_expected_index_ >= stream_end_index_ ) {
-    output.close();
+  staged_intervals_.emplace( start, end );
+  bytes_staged_ += newly_covered;
+
+  // Publish the front interval once the gap before it is filled
+  const auto front = staged_intervals_.begin();
+  if ( front->first == next_expected_index_ ) {
+    const auto len = front->second - front->first;
+    output.commit( len );
+    next_expected_index_ += len;
+    bytes_staged_ -= len;
+    staged_intervals_.erase( front );
   }
+
+  evict_excess_intervals();
 }
 
-uint64_t Reassembler::bytes_pending() const
+void Reassembler::evict_excess_intervals()
 {
-  uint64_t total = 0;
-  for ( const auto& segment : unassembled_substrings_ ) {
-    total += segment.second.size();
+  // Drop from the far end of the window: those bytes are the last that could be written anyway. A range of
+  // abutting substrings goes as a whole.
+  while ( buffered_ranges_ > max_pending_intervals_ ) {
+    erase_buffered( std::prev( unassembled_substrings_.end() ) );
   }
-  return total;
+  while ( staged_intervals_.size() > max_pending_intervals_ ) {
+    const auto last = std::prev( staged_intervals_.end() );
+    bytes_staged_ -= last->second - last->first;
+    staged_intervals_.erase( last );
+  }
+}
+
+void Reassembler::store_buffered( map<uint64_t, Buffer>::iterator hint, uint64_t index, Buffer slice )
+{
+  // The new substring starts a range of its own, unless it joins the one before or after (or bridges them)
+  bytes_buffered_ += slice.size();
+  const auto piece = unassembled_substrings_.emplace_hint( hint, index, std::move( slice ) );
+  const auto next = std::next( piece );
+  const bool joins_prev = piece != unassembled_substrings_.begin() && end_of( *std::prev( piece ) ) == index;
+  const bool joins_next = next != unassembled_substrings_.end() && next->first == end_of( *piece );
+  buffered_ranges_ = buffered_ranges_ + 1 - joins_prev - joins_next;
+}
+
+void Reassembler::erase_buffered( map<uint64_t, Buffer>::iterator piece )
+{
+  // Erasing a substring ends its range, shortens it, or splits it in two
+  const auto next = std::next( piece );
+  const bool joins_prev = piece != unassembled_substrings_.begin() && end_of( *std::prev( piece ) ) == piece->first;
+  const bool joins_next = next != unassembled_substrings_.end() && next->first == end_of( *piece );
+  buffered_ranges_ = buffered_ranges_ + joins_prev + joins_next - 1;
+  bytes_buffered_ -= piece->second.size();
+  unassembled_substrings_.erase( piece );
+}
+
+optional<pair<uint64_t, uint64_t>> Reassembler::pending_range_containing( uint64_t index ) const
+{
+  return staged_intervals_.empty() ? merged_range_containing( unassembled_substrings_, index )
+                                   : merged_range_containing( staged_intervals_, index );
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges( size_t max_ranges ) const
+{
+  return staged_intervals_.empty() ? merged_ranges( unassembled_substrings_, max_ranges )
+                                   : merged_ranges( staged_intervals_, max_ranges );
 }
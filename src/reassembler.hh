@@ -2,14 +2,60 @@
 
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 class Reassembler
 {
+public:
+  // Buffered: keep out-of-order substrings in the Reassembler until the gap before them is filled.
+  // Direct: stage out-of-order bytes straight into the output stream's free space (Writer::stage) and only
+  //         track which intervals have arrived, so each byte is copied once. Falls back to Buffered when
+  //         the output is a Rope stream, which has no contiguous free space to stage into.
+  enum class Placement : uint8_t
+  {
+    Buffered,
+    Direct
+  };
+
+  // Out-of-order data is held in at most this many separate ranges (intervals); see max_pending_intervals_
+  static constexpr uint64_t MAX_PENDING_INTERVALS_DFLT = 1024;
+
+  explicit Reassembler( Placement placement = Placement::Buffered,
+                        uint64_t max_pending_intervals = MAX_PENDING_INTERVALS_DFLT )
+    : placement_( placement ), max_pending_intervals_( std::max( max_pending_intervals, uint64_t { 1 } ) )
+  {}
+
 private:
-  // Store unassembled substrings, indexed by their starting position
-  std::map<uint64_t, std::string> unassembled_substrings_;
+  Placement placement_;
+
+  // A peer sending many tiny disjoint segments can't make us track more than this many ranges: past the
+  // cap, the ranges furthest from the next expected index are dropped (the peer will have to resend them).
+  // Abutting pieces form one range, so contiguous data past a single hole is never dropped.
+  uint64_t max_pending_intervals_;
+
+  // Direct placement: the staged intervals (first index -> one past the last index), disjoint and
+  // non-adjacent, and the number of bytes they cover
+  std::map<uint64_t, uint64_t> staged_intervals_ {};
+  uint64_t bytes_staged_ {};
+
+  void insert_direct( uint64_t first_index, std::string_view data, Writer& output );
+  void insert_buffered( uint64_t first_index, const Buffer& data, Writer& output );
+  void evict_excess_intervals();
+  void store_buffered( std::map<uint64_t, Buffer>::iterator hint, uint64_t index, Buffer slice );
+  void erase_buffered( std::map<uint64_t, Buffer>::iterator piece );
+
+  // Store unassembled substrings, indexed by their starting position. Each is a slice of the Buffer it
+  // arrived in, trimmed so that no two overlap; bytes are never copied until they are written.
+  std::map<uint64_t, Buffer> unassembled_substrings_ {};
+  uint64_t bytes_buffered_ {}; // Total size of unassembled_substrings_
+  uint64_t buffered_ranges_ {}; // How many contiguous ranges they form (abutting substrings count once)
   
   // The index of the next byte we expect to write to the stream
   uint64_t next_expected_index_ = 0;
@@ -43,6 +89,20 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
 
-  // How many bytes are stored in the Reassembler itself?
-  uint64_t bytes_pending() const;
+  // As above, but keeps any part of `data` it must hold as a slice of the Buffer, sharing its bytes
+  void insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output );
+
+  // How many bytes are stored in the Reassembler itself (or staged in the output, for Direct placement)?
+  uint64_t bytes_pending() const { return bytes_buffered_ + bytes_staged_; }
+
+  // How many separate ranges of out-of-order data are being held?
+  uint64_t pending_intervals() const { return buffered_ranges_ + staged_intervals_.size(); }
+
+  // The contiguous range [first, last) of out-of-order bytes being held that includes `index`, if any
+  std::optional<std::pair<uint64_t, uint64_t>> pending_range_containing( uint64_t index ) const;
+
+  // Up to `max_ranges` of the contiguous ranges of out-of-order bytes being held, lowest first
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges( size_t max_ranges ) const;
+
+  Placement placement() const { return placement_; }
 };
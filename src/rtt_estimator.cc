@@ -0,0 +1,31 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+RTTEstimator::RTTEstimator( uint64_t initial_rto_ms, uint64_t min_rto_ms, uint64_t max_rto_ms )
+  : min_rto_ms_( min_rto_ms ), max_rto_ms_( max( min_rto_ms, max_rto_ms ) ), rto_ms_( initial_rto_ms )
+{}
+
+void RTTEstimator::add_sample( uint64_t rtt_ms )
+{
+  const double rtt = static_cast<double>( rtt_ms );
+  if ( not srtt_ms_.has_value() ) {
+    srtt_ms_ = rtt;
+    rttvar_ms_ = rtt / 2;
+  } else {
+    // RTTVAR is updated first, against the old SRTT (RFC 6298 2.3)
+    rttvar_ms_ = ( 1 - BETA ) * rttvar_ms_ + BETA * abs( srtt_ms_.value() - rtt );
+    srtt_ms_ = ( 1 - ALPHA ) * srtt_ms_.value() + ALPHA * rtt;
+  }
+
+  const double rto = srtt_ms_.value() + max( static_cast<double>( CLOCK_GRANULARITY_MS ), 4 * rttvar_ms_ );
+  rto_ms_ = clamp( static_cast<uint64_t>( ceil( rto ) ), min_rto_ms_, max_rto_ms_ );
+}
+
+uint64_t RTTEstimator::backed_off( uint64_t rto_ms ) const
+{
+  return min( 2 * rto_ms, max( max_rto_ms_, rto_ms ) );
+}
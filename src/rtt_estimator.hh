@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+/*
+ * An RTTEstimator keeps the smoothed round-trip time (SRTT) and its mean deviation (RTTVAR), and from them
+ * computes the retransmission timeout, as in RFC 6298. The caller is responsible for Karn's rule: only
+ * segments that were never retransmitted may be sampled, since an ack of a retransmitted segment can't be
+ * matched to a particular transmission (unless a timestamp echo says which one it answers).
+ *
+ * All times are in milliseconds.
+ */
+class RTTEstimator
+{
+  static constexpr double ALPHA = 1.0 / 8;            // Gain of the SRTT filter
+  static constexpr double BETA = 1.0 / 4;             // Gain of the RTTVAR filter
+  static constexpr uint64_t CLOCK_GRANULARITY_MS = 1; // "G": the sender's clock ticks in milliseconds
+
+  uint64_t min_rto_ms_;
+  uint64_t max_rto_ms_;
+  std::optional<double> srtt_ms_ {};
+  double rttvar_ms_ {};
+  uint64_t rto_ms_;
+
+public:
+  RTTEstimator( uint64_t initial_rto_ms, uint64_t min_rto_ms, uint64_t max_rto_ms );
+
+  // A segment sent `rtt_ms` ago (and never retransmitted, or identified by its timestamp) has just been acked
+  void add_sample( uint64_t rtt_ms );
+
+  std::optional<double> srtt_ms() const { return srtt_ms_; } // Empty until the first sample
+  double rttvar_ms() const { return rttvar_ms_; }
+  uint64_t rto_ms() const { return rto_ms_; } // Before any backoff
+
+  // The timeout after backing off from `rto_ms` (doubled, but never beyond the maximum)
+  uint64_t backed_off( uint64_t rto_ms ) const;
+};
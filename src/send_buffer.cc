@@ -0,0 +1,53 @@
+#include "send_buffer.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+void SendBuffer::append( uint64_t index, Buffer data )
+{
+  if ( data.empty() ) {
+    return;
+  }
+  if ( not pieces_.empty() and pieces_.back().end() != index ) {
+    throw runtime_error( "SendBuffer::append: data does not follow what is held" );
+  }
+  bytes_held_ += data.size();
+  pieces_.push_back( { index, move( data ) } );
+}
+
+void SendBuffer::release_before( uint64_t index )
+{
+  while ( not pieces_.empty() and pieces_.front().end() <= index ) {
+    bytes_held_ -= pieces_.front().data.size();
+    pieces_.pop_front();
+  }
+}
+
+Buffer SendBuffer::range( uint64_t index, uint64_t len ) const
+{
+  if ( len == 0 ) {
+    return {};
+  }
+  if ( pieces_.empty() or index < pieces_.front().index or index + len > pieces_.back().end() ) {
+    throw runtime_error( "SendBuffer::range: bytes are not held" );
+  }
+
+  // Find the piece holding the first byte
+  auto piece = prev( upper_bound(
+    pieces_.begin(), pieces_.end(), index, []( uint64_t i, const Piece& p ) { return i < p.index; } ) );
+  if ( index + len <= piece->end() ) {
+    return piece->data.slice( index - piece->index, len );
+  }
+
+  string data;
+  data.reserve( len );
+  for ( ; data.size() < len; ++piece ) {
+    const uint64_t offset = index + data.size() - piece->index;
+    data += string_view { piece->data }.substr( offset, len - data.size() );
+  }
+  return Buffer { move( data ) };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "buffer.hh"
+
+#include <cstdint>
+#include <deque>
+
+/*
+ * A SendBuffer holds the bytes a TCP sender has sent but not yet seen acknowledged, so that any range of
+ * them can be sent again. The bytes are kept as the Buffers the outbound stream handed over (shared, not
+ * copied) and are addressed by their index in the stream.
+ */
+class SendBuffer
+{
+  struct Piece
+  {
+    uint64_t index; // Stream index of the piece's first byte
+    Buffer data;
+
+    uint64_t end() const { return index + data.size(); }
+  };
+  std::deque<Piece> pieces_ {}; // In stream order, without gaps
+  uint64_t bytes_held_ {};
+
+public:
+  // Add the next `data.size()` bytes of the stream, starting at stream index `index`
+  void append( uint64_t index, Buffer data );
+
+  // Drop the pieces that lie wholly before stream index `index`
+  void release_before( uint64_t index );
+
+  // The `len` bytes starting at stream index `index`, which must still be held. Sharing a piece if they lie
+  // within one, or copied into a new Buffer if not.
+  Buffer range( uint64_t index, uint64_t len ) const;
+
+  uint64_t bytes_held() const { return bytes_held_; }
+};
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream )
@@ -7,6 +9,7 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
   // Set the Initial Sequence Number if this is the first SYN segment
   if ( message.SYN && !isn_.has_value() ) {
     isn_ = message.seqno;
+    sack_permitted_ = message.SACK_permitted;
   }
   
   // Only process the message if we have received the ISN
@@ -27,16 +30,49 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
     stream_index = 0;
   }
   
+  // PAWS: drop an old duplicate. Otherwise, a segment starting at or before the last ackno sent brings the
+  // timestamp to echo (RFC 7323 section 4.3).
+  if ( message.timestamp.has_value() ) {
+    if ( ts_recent_.has_value() && !message.SYN
+         && static_cast<int32_t>( message.timestamp.value() - ts_recent_.value() ) < 0 ) {
+      return;
+    }
+    if ( stream_index <= last_ack_sent_.value_or( inbound_stream.bytes_pushed() ) ) {
+      ts_recent_ = message.timestamp;
+    }
+  }
+
   // Insert the payload into the reassembler
-  reassembler.insert( stream_index, message.payload.release(), message.FIN, inbound_stream );
+  const bool has_payload = not message.payload.empty();
+  reassembler.insert( stream_index, std::move( message.payload ), message.FIN, inbound_stream );
+
+  // Remember where data arrived beyond a gap, to report it in SACK blocks
+  if ( sack_permitted_ && has_payload && stream_index > inbound_stream.bytes_pushed() ) {
+    std::erase( recent_out_of_order_, stream_index );
+    recent_out_of_order_.push_front( stream_index );
+    if ( recent_out_of_order_.size() > TCPReceiverMessage::MAX_SACK_BLOCKS ) {
+      recent_out_of_order_.pop_back();
+    }
+  }
+}
+
+void TCPReceiver::ack_sent( Wrap32 ackno )
+{
+  if ( isn_.has_value() ) {
+    // Acknos only move forward, so the last one is a good checkpoint. The SYN takes absolute seqno 0.
+    const uint64_t abs_ackno = ackno.unwrap( isn_.value(), last_ack_sent_.value_or( 0 ) + 1 );
+    last_ack_sent_ = max<uint64_t>( abs_ackno, 1 ) - 1;
+  }
 }
 
 TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
 {
   TCPReceiverMessage result;
   
-  // Set window size to the available capacity
-  result.window_size = inbound_stream.available_capacity() > UINT16_MAX ? UINT16_MAX : inbound_stream.available_capacity();
+  // Set window size to the available capacity, as far as the header can express it
+  const uint64_t max_window = uint64_t { UINT16_MAX } << window_shift_;
+  const uint64_t window = min( inbound_stream.available_capacity(), max_window );
+  result.window_size = static_cast<uint32_t>( window >> window_shift_ << window_shift_ );
   
   // Only set ackno if we have received the ISN
   if ( isn_.has_value() ) {
@@ -51,7 +87,45 @@ TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
     
     // Wrap it back to a 32-bit sequence number
     result.ackno = Wrap32::wrap( next_abs_seqno, isn_.value() );
+    result.timestamp_echo = ts_recent_;
   }
   
   return result;
 }
+
+TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream, const Reassembler& reassembler ) const
+{
+  TCPReceiverMessage result = send( inbound_stream );
+  if ( !sack_permitted_ || !isn_.has_value() ) {
+    return result;
+  }
+
+  // The blocks holding the most recent arrivals first, then any others from the lowest up
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  const auto add = [&]( const std::pair<uint64_t, uint64_t>& range ) {
+    if ( ranges.size() < TCPReceiverMessage::MAX_SACK_BLOCKS
+         && std::find( ranges.begin(), ranges.end(), range ) == ranges.end() ) {
+      ranges.push_back( range );
+    }
+  };
+  for ( const auto index : recent_out_of_order_ ) {
+    const auto range = reassembler.pending_range_containing( index );
+    if ( range.has_value() ) {
+      add( range.value() );
+    }
+  }
+  for ( const auto& range : reassembler.pending_ranges( TCPReceiverMessage::MAX_SACK_BLOCKS ) ) {
+    add( range );
+  }
+
+  // Stream index i is absolute sequence number i + 1 (the SYN comes first)
+  for ( const auto& [first, last] : ranges ) {
+    result.sack.push_back( { Wrap32::wrap( first + 1, isn_.value() ), Wrap32::wrap( last + 1, isn_.value() ) } );
+  }
+  return result;
+}
+
+void TCPReceiver::set_window_shift( uint8_t shift )
+{
+  window_shift_ = min( shift, TCPReceiverMessage::MAX_WINDOW_SHIFT );
+}
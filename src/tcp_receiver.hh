@@ -4,6 +4,7 @@
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <deque>
 #include <optional>
 
 class TCPReceiver
@@ -18,7 +19,35 @@ public:
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
 
+  /* As above, adding SACK blocks for the out-of-order data the Reassembler holds, if the sender permitted them */
+  TCPReceiverMessage send( const Writer& inbound_stream, const Reassembler& reassembler ) const;
+
+  /* A TCPReceiverMessage with this ackno went out to the sender (RFC 7323's "Last.ACK.sent") */
+  void ack_sent( Wrap32 ackno );
+
+  /* The peers agreed on window scaling: windows will be shifted right by `shift` to fit in the header */
+  void set_window_shift( uint8_t shift );
+
 private:
   // Track the initial sequence number (ISN) and whether it's been set
-  std::optional<Wrap32> isn_;
+  std::optional<Wrap32> isn_ {};
+
+  // Whether the sender's SYN carried the SACK-permitted option
+  bool sack_permitted_ {};
+
+  // Window scale (RFC 7323): advertised windows are multiples of 1 << window_shift_, up to UINT16_MAX of them
+  uint8_t window_shift_ {};
+
+  // Timestamps (RFC 7323): the TSval to echo ("TS.Recent"), taken from the latest segment that starts at or
+  // before the last ackno sent. With acks delayed, that's the earliest segment the next ack covers, so the
+  // sender's RTT sample includes the delay. A segment with an older timestamp is an old duplicate from an
+  // earlier wrap of the sequence numbers, and PAWS (protection against wrapped sequence numbers) drops it.
+  std::optional<uint32_t> ts_recent_ {};
+
+  // Stream index the last ackno sent asked for; until one is sent, the current ackno stands in for it
+  std::optional<uint64_t> last_ack_sent_ {};
+
+  // Stream indices of the latest segments that arrived out of order, most recent first (RFC 2018 asks for
+  // the block holding the latest one to be reported first, and for recent blocks to be repeated)
+  std::deque<uint64_t> recent_out_of_order_ {};
 };
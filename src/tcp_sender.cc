@@ -1,15 +1,32 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <random>
 
 using namespace std;
 
 /* TCPSender constructor (uses a random ISN if none given) */
-TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn )
-  : isn_( fixed_isn.value_or( Wrap32 { random_device()() } ) )
-  , initial_RTO_ms_( initial_RTO_ms )
-  , current_RTO_ms_( initial_RTO_ms )
+TCPSender::TCPSender( const TCPConfig& config )
+  : isn_( config.fixed_isn.value_or( Wrap32 { random_device()() } ) )
+  , initial_RTO_ms_( config.rt_timeout )
+  , advertised_mss_( config.mss.value_or( static_cast<uint16_t>( TCPConfig::MAX_PAYLOAD_SIZE ) ) )
+  , mss_( advertised_mss_ )
+  , window_scale_( config.window_scaling ? TCPConfig::window_shift_for( config.max_recv_capacity() )
+                                         : std::optional<uint8_t> {} )
+  , segmentation_offload_( config.segmentation_offload )
+  , nagle_( not config.nodelay )
+  , congestion_control_( config.congestion_control )
+  , congestion_( CongestionController::make( congestion_control_, mss_ ) )
+  , current_RTO_ms_( config.rt_timeout )
+  , fast_retransmit_( config.congestion_control != CongestionControl::None )
+  , sack_enabled_( config.sack )
+  , estimate_rto_( config.estimate_rto )
+  , rtt_( config.rt_timeout, config.min_rto, config.max_rto )
+  , timestamps_offered_( config.timestamps )
+  , rack_tlp_( config.rack_tlp and fast_retransmit_ and estimate_rto_ )
 {}
 
 uint64_t TCPSender::sequence_numbers_in_flight() const
@@ -22,6 +39,41 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retx_;
 }
 
+uint64_t TCPSender::congestion_window() const
+{
+  return congestion_->cwnd();
+}
+
+uint64_t TCPSender::slow_start_threshold() const
+{
+  return congestion_->ssthresh();
+}
+
+const RTTEstimator& TCPSender::rtt_estimator() const
+{
+  return rtt_;
+}
+
+uint64_t TCPSender::mss() const
+{
+  return mss_;
+}
+
+bool TCPSender::segmentation_offload() const
+{
+  return segmentation_offload_;
+}
+
+bool TCPSender::corked() const
+{
+  return corked_;
+}
+
+bool TCPSender::timestamps() const
+{
+  return timestamps_;
+}
+
 optional<TCPSenderMessage> TCPSender::maybe_send()
 {
   if ( messages_to_send_.empty() ) {
@@ -30,13 +82,70 @@ optional<TCPSenderMessage> TCPSender::maybe_send()
 
   TCPSenderMessage msg = messages_to_send_.front();
   messages_to_send_.pop();
+  add_timestamp( msg );
   return msg;
 }
 
+optional<uint64_t> TCPSender::next_send_time() const
+{
+  if ( not held_by_pacer_ ) {
+    return {};
+  }
+  return static_cast<uint64_t>( max( 0.0, ceil( next_release_ms_ - static_cast<double>( time_elapsed_ ) ) ) );
+}
+
+bool TCPSender::pacer_ready() const
+{
+  return not congestion_->pacing_rate().has_value() or static_cast<double>( time_elapsed_ ) >= next_release_ms_;
+}
+
+void TCPSender::transmit( TCPSenderMessage msg, const Reader& outbound_stream )
+{
+  // With nothing in flight, a new delivery-rate sampling interval starts now
+  if ( outstanding_segments_.empty() ) {
+    first_sent_ms_ = delivered_ms_ = time_elapsed_;
+  }
+
+  // Our clock ticks in whole milliseconds, so let up to a millisecond's worth of credit build up
+  const auto rate = congestion_->pacing_rate();
+  if ( rate.has_value() and msg.payload.size() > 0 ) {
+    next_release_ms_ = max( next_release_ms_, static_cast<double>( time_elapsed_ ) - 1 )
+                       + static_cast<double>( msg.sequence_length() ) / rate.value();
+  }
+
+  // Track the message an MSS at a time (with segmentation offload, it may hold many), so that loss recovery
+  // works on the packets the network actually sees
+  const bool app_limited
+    = outbound_stream.bytes_buffered() == 0 and bytes_in_flight_ + msg.sequence_length() < window_size();
+  send_buffer_.append( next_seqno_ + msg.SYN - 1, msg.payload );
+  uint64_t offset = 0;
+  do {
+    const uint64_t size = min( mss_, msg.payload.size() - offset );
+    const OutstandingSegment seg { next_seqno_,
+                                   size,
+                                   msg.SYN and offset == 0,
+                                   msg.FIN and offset + size == msg.payload.size(),
+                                   time_elapsed_,
+                                   first_sent_ms_,
+                                   delivered_,
+                                   delivered_ms_,
+                                   app_limited };
+    bytes_in_flight_ += seg.sequence_length();
+    next_seqno_ += seg.sequence_length();
+    outstanding_segments_.push_back( seg );
+    offset += size;
+  } while ( offset < msg.payload.size() );
+  messages_to_send_.push( move( msg ) );
+
+  start_timer_if_needed();
+  arm_probe_timer();
+}
+
 void TCPSender::push( Reader& outbound_stream )
 {
   // Get effective window size (special case for zero window)
   uint64_t window = window_size();
+  held_by_pacer_ = false;
 
   // If we haven't sent SYN yet, send it
   if ( !syn_sent_ ) {
@@ -44,7 +153,10 @@ void TCPSender::push( Reader& outbound_stream )
     msg.seqno = isn_;
     msg.SYN = true;
     msg.payload = Buffer {};
-    
+    msg.SACK_permitted = sack_enabled_;
+    msg.MSS = advertised_mss_;
+    msg.window_scale = window_scale_;
+
     // Check if we should also set FIN (if stream is already finished and we have window space)
     msg.FIN = !fin_sent_ && outbound_stream.is_finished() && window >= 2;
     
@@ -53,30 +165,41 @@ void TCPSender::push( Reader& outbound_stream )
     }
 
     syn_sent_ = true;
-    bytes_in_flight_ += msg.sequence_length();
-    outstanding_segments_.push( msg );
-    messages_to_send_.push( msg );
-    next_seqno_ += msg.sequence_length();
-
-    start_timer_if_needed();
+    transmit( move( msg ), outbound_stream );
     return;
   }
 
   // Send data segments while there's window space and data available
   while ( bytes_in_flight_ < window && outbound_stream.bytes_buffered() > 0 ) {
+    if ( not pacer_ready() ) {
+      held_by_pacer_ = true;
+      break;
+    }
+    if ( hold_small_segment( outbound_stream ) ) {
+      break;
+    }
+
     TCPSenderMessage msg;
     msg.seqno = isn_ + next_seqno_;
     msg.SYN = false;
 
     // Calculate available window space
     uint64_t available_space = window - bytes_in_flight_;
-    uint64_t bytes_to_send = min(
-      { outbound_stream.bytes_buffered(), available_space, static_cast<uint64_t>( TCPConfig::MAX_PAYLOAD_SIZE ) } );
+    const uint64_t max_payload = segmentation_offload_ ? TCPConfig::MAX_OFFLOAD_SIZE : mss_;
+    uint64_t bytes_to_send = min( { outbound_stream.bytes_buffered(), available_space, max_payload } );
 
-    // Read data from stream
-    string data;
-    read( outbound_stream, bytes_to_send, data );
-    msg.payload = Buffer( move( data ) );
+    // Take data from stream (sharing, not copying, the application's Buffer if the payload lies within one)
+    auto pieces = outbound_stream.pop_buffers( bytes_to_send );
+    if ( pieces.size() == 1 ) {
+      msg.payload = move( pieces.front() );
+    } else {
+      string data;
+      data.reserve( bytes_to_send );
+      for ( const auto& piece : pieces ) {
+        data += string_view { piece };
+      }
+      msg.payload = Buffer( move( data ) );
+    }
 
     // Check if we should set FIN flag
     msg.FIN = !fin_sent_ && outbound_stream.is_finished() && available_space > msg.payload.size();
@@ -87,12 +210,7 @@ void TCPSender::push( Reader& outbound_stream )
 
     // Only send if message has content
     if ( msg.sequence_length() > 0 ) {
-      bytes_in_flight_ += msg.sequence_length();
-      outstanding_segments_.push( msg );
-      messages_to_send_.push( msg );
-      next_seqno_ += msg.sequence_length();
-
-      start_timer_if_needed();
+      transmit( move( msg ), outbound_stream );
     }
   }
 
@@ -105,13 +223,351 @@ void TCPSender::push( Reader& outbound_stream )
     msg.FIN = true;
 
     fin_sent_ = true;
-    bytes_in_flight_ += msg.sequence_length();
-    outstanding_segments_.push( msg );
-    messages_to_send_.push( msg );
-    next_seqno_ += msg.sequence_length();
+    transmit( move( msg ), outbound_stream );
+  }
+}
 
-    start_timer_if_needed();
+bool TCPSender::hold_small_segment( const Reader& outbound_stream ) const
+{
+  // A full segment, or the last of the stream, always goes
+  if ( outbound_stream.bytes_buffered() >= mss_ or outbound_stream.writer().is_closed() ) {
+    return false;
+  }
+  return corked_ or ( nagle_ and bytes_in_flight_ > 0 );
+}
+
+TCPSenderMessage TCPSender::make_message( const OutstandingSegment& seg ) const
+{
+  TCPSenderMessage msg;
+  msg.seqno = isn_ + seg.start;
+  msg.SYN = seg.SYN;
+  msg.payload = send_buffer_.range( seg.stream_index(), seg.payload_size );
+  msg.FIN = seg.FIN;
+  msg.SACK_permitted = seg.SYN and sack_enabled_;
+  if ( seg.SYN ) {
+    msg.MSS = advertised_mss_;
+    msg.window_scale = window_scale_;
+  }
+  return msg;
+}
+
+void TCPSender::retransmit( OutstandingSegment& seg )
+{
+  seg.retransmitted = true;
+  seg.sent_ms = time_elapsed_;
+  messages_to_send_.push( make_message( seg ) );
+}
+
+template<typename Mergeable>
+TCPSender::OutstandingSegment& TCPSender::coalesce( size_t index, Mergeable mergeable )
+{
+  // Take in the unsacked data that follows, while it's contiguous and `mergeable`, until the segment carries a
+  // full MSS. A segment only partly taken in keeps the rest (and its own send time).
+  while ( index + 1 < outstanding_segments_.size() ) {
+    auto& seg = outstanding_segments_[index];
+    auto& next = outstanding_segments_[index + 1];
+    if ( seg.FIN or seg.payload_size >= mss_ or next.sacked or next.start != seg.end() or not mergeable( next ) ) {
+      break;
+    }
+    const uint64_t take = min( mss_ - seg.payload_size, next.payload_size );
+    if ( take < next.payload_size ) {
+      seg.payload_size += take;
+      next.start += take;
+      next.payload_size -= take;
+      break;
+    }
+    seg.payload_size += take;
+    seg.FIN = next.FIN;
+    outstanding_segments_.erase( outstanding_segments_.begin() + static_cast<int64_t>( index ) + 1 );
   }
+  return outstanding_segments_[index];
+}
+
+void TCPSender::retransmit_first_outstanding()
+{
+  // Like any retransmission from the front, it starts at the ackno and carries up to an MSS of what follows
+  retransmit( coalesce( 0, []( const OutstandingSegment& ) { return true; } ) );
+}
+
+void TCPSender::receive_duplicate_ack()
+{
+  ++duplicate_acks_;
+
+  if ( in_fast_recovery_ ) {
+    if ( receiver_sacks_ ) {
+      retransmit_sacked_holes();
+    } else {
+      // Another segment has left the network, so another may enter it
+      window_inflation_ += mss_;
+    }
+    return;
+  }
+
+  // Three duplicates (or, with SACK, more than two segments' worth acked past the first hole) mean a segment
+  // was lost, rather than reordered. Don't go into recovery again for duplicates of data that was sent
+  // before the last recovery began, though.
+  const bool lost = duplicate_acks_ >= 3 or sacked_bytes_ > 2 * mss_;
+  if ( lost and ackd_seqno_ >= recover_ ) {
+    enter_fast_recovery();
+  }
+}
+
+void TCPSender::enter_fast_recovery()
+{
+  congestion_->on_loss( bytes_in_flight_, time_elapsed_ );
+  in_fast_recovery_ = true;
+  recover_ = next_seqno_;
+  probe_end_ = 0;
+  retransmit_first_outstanding();
+
+  if ( receiver_sacks_ ) {
+    high_retransmitted_ = outstanding_segments_.front().end();
+    retransmit_sacked_holes();
+  } else {
+    window_inflation_ = 3 * mss_;
+  }
+}
+
+void TCPSender::update_scoreboard( const vector<SACKBlock>& blocks )
+{
+  if ( not sack_enabled_ or blocks.empty() ) {
+    return;
+  }
+  receiver_sacks_ = true;
+
+  // Mark the segments that lie wholly within each block, finding the first by binary search
+  for ( const auto& block : blocks ) {
+    const uint64_t left = block.left.unwrap( isn_, ackd_seqno_ );
+    const uint64_t right = block.right.unwrap( isn_, ackd_seqno_ );
+    auto seg = lower_bound( outstanding_segments_.begin(),
+                            outstanding_segments_.end(),
+                            left,
+                            []( const OutstandingSegment& s, uint64_t index ) { return s.start < index; } );
+    for ( ; seg != outstanding_segments_.end() and seg->end() <= right; ++seg ) {
+      if ( not seg->sacked ) {
+        seg->sacked = true;
+        sacked_bytes_ += seg->sequence_length();
+        rack_update( *seg );
+      }
+    }
+  }
+}
+
+void TCPSender::retransmit_sacked_holes()
+{
+  // Walk the scoreboard from the top. A segment is lost once more than two segments' worth above it has
+  // been sacked (RFC 6675's IsLost). The "pipe" is what is still in the network: segments neither sacked
+  // nor lost, plus the retransmissions of this recovery.
+  uint64_t sacked_above = 0;
+  uint64_t pipe = 0;
+  uint64_t lost_end = 0; // Every unsacked segment that ends here or before is lost
+  for ( auto seg = outstanding_segments_.rbegin(); seg != outstanding_segments_.rend(); ++seg ) {
+    const uint64_t len = seg->sequence_length();
+    if ( seg->sacked ) {
+      sacked_above += len;
+      continue;
+    }
+    const bool lost = sacked_above > 2 * mss_;
+    if ( not lost ) {
+      pipe += len;
+    } else if ( lost_end == 0 ) {
+      lost_end = seg->end();
+    }
+    if ( seg->start < high_retransmitted_ ) {
+      pipe += len;
+    }
+  }
+
+  // Repair the holes not yet retransmitted, lowest first, as far as the congestion window allows. Adjacent
+  // lost segments go out together, up to an MSS at a time.
+  const auto first = lower_bound( outstanding_segments_.begin(),
+                                  outstanding_segments_.end(),
+                                  high_retransmitted_,
+                                  []( const OutstandingSegment& s, uint64_t index ) { return s.start < index; } );
+  const auto is_lost = [&]( const OutstandingSegment& s ) { return s.end() <= lost_end; };
+  for ( auto i = static_cast<size_t>( first - outstanding_segments_.begin() );
+        i < outstanding_segments_.size() and pipe < congestion_->cwnd();
+        ++i ) {
+    if ( not is_lost( outstanding_segments_[i] ) ) {
+      break;
+    }
+    if ( outstanding_segments_[i].sacked ) {
+      continue;
+    }
+    auto& hole = coalesce( i, is_lost );
+    retransmit( hole );
+    pipe += hole.sequence_length();
+    high_retransmitted_ = hole.end();
+  }
+
+  // New data may fill whatever the congestion window has left over
+  window_inflation_ = bytes_in_flight_ - min( pipe, bytes_in_flight_ );
+}
+
+void TCPSender::rack_update( const OutstandingSegment& seg )
+{
+  if ( not rack_tlp_ ) {
+    return;
+  }
+
+  // An ack sooner than any round trip yet must be for an earlier transmission of a retransmitted segment, which
+  // says nothing about when the retransmission arrived
+  const uint64_t rtt = time_elapsed_ - seg.sent_ms;
+  if ( seg.retransmitted and rack_min_rtt_.has_value() and rtt < rack_min_rtt_.value() ) {
+    return;
+  }
+  if ( not seg.retransmitted ) {
+    rack_min_rtt_ = min( rack_min_rtt_.value_or( rtt ), rtt );
+  }
+
+  if ( seg.sent_ms > rack_xmit_ms_ or ( seg.sent_ms == rack_xmit_ms_ and seg.end() > rack_end_ ) ) {
+    rack_xmit_ms_ = seg.sent_ms;
+    rack_end_ = seg.end();
+    rack_rtt_ = rtt;
+  }
+}
+
+void TCPSender::rack_detect_losses()
+{
+  if ( not rack_tlp_ or not receiver_sacks_ or not rack_rtt_.has_value() ) {
+    return;
+  }
+
+  // A segment sent before one that has been delivered is lost once it has had that segment's round-trip time,
+  // plus a reordering window (a quarter of the smallest round-trip time, but no more than SRTT), to arrive.
+  // Until then, the reordering timer is set for the first such segment to run out of time.
+  uint64_t reordering_window = rack_min_rtt_.value_or( 0 ) / 4;
+  if ( rtt_.srtt_ms().has_value() ) {
+    reordering_window = min( reordering_window, static_cast<uint64_t>( rtt_.srtt_ms().value() ) );
+  }
+  const auto sent_before_delivered = [&]( const OutstandingSegment& seg ) {
+    return seg.sent_ms < rack_xmit_ms_ or ( seg.sent_ms == rack_xmit_ms_ and seg.end() < rack_end_ );
+  };
+  const auto deadline = [&]( const OutstandingSegment& seg ) {
+    return seg.sent_ms + rack_rtt_.value() + reordering_window;
+  };
+  const auto is_lost = [&]( const OutstandingSegment& seg ) {
+    return sent_before_delivered( seg ) and deadline( seg ) <= time_elapsed_;
+  };
+
+  // Repair the losses in SACK recovery, starting it if need be. (A lost retransmission is sent again.) Adjacent
+  // lost segments go out together, up to an MSS at a time. Every segment after one that was never retransmitted
+  // was sent later than it, so the scan stops at the first of those that isn't lost (RFC 8985 section 6.2):
+  // none of the rest is, and none has an earlier deadline.
+  reorder_timer_until_ = 0;
+  bool found_loss = false;
+  for ( size_t i = 0; i < outstanding_segments_.size(); ++i ) {
+    const auto& seg = outstanding_segments_[i];
+    if ( not sent_before_delivered( seg ) ) {
+      if ( seg.retransmitted ) {
+        continue;
+      }
+      break;
+    }
+    if ( seg.sacked ) {
+      continue;
+    }
+    if ( not is_lost( seg ) ) {
+      if ( reorder_timer_until_ == 0 or deadline( seg ) < reorder_timer_until_ ) {
+        reorder_timer_until_ = deadline( seg );
+      }
+      if ( seg.retransmitted ) {
+        continue;
+      }
+      break;
+    }
+    if ( not in_fast_recovery_ ) {
+      congestion_->on_loss( bytes_in_flight_, time_elapsed_ );
+      in_fast_recovery_ = true;
+      recover_ = next_seqno_;
+      probe_end_ = 0;
+    }
+    found_loss = true;
+    auto& lost = coalesce( i, is_lost );
+    retransmit( lost );
+    high_retransmitted_ = max( high_retransmitted_, lost.end() );
+  }
+  if ( found_loss ) {
+    retransmit_sacked_holes();
+  }
+}
+
+void TCPSender::arm_probe_timer()
+{
+  probe_timer_until_ = 0;
+  if ( not rack_tlp_ or probe_end_ > 0 or in_fast_recovery_ or consecutive_retx_ > 0
+       or outstanding_segments_.empty() or receiver_window_size_ == 0 or not rtt_.srtt_ms().has_value() ) {
+    return;
+  }
+
+  // Two round trips, plus the longest a lone segment's ack may be delayed, but no later than the retransmission
+  // timer would expire (so that the probe goes instead of a timeout, which would collapse the congestion window)
+  uint64_t timeout = static_cast<uint64_t>( ceil( 2 * rtt_.srtt_ms().value() ) );
+  if ( bytes_in_flight_ <= mss_ ) {
+    timeout += TCPConfig::MAX_ACK_DELAY;
+  }
+  probe_timer_until_ = time_elapsed_ + timeout;
+  if ( timer_running_until_ > 0 ) {
+    probe_timer_until_ = min( probe_timer_until_, timer_running_until_ );
+  }
+}
+
+void TCPSender::set_peer_mss( uint16_t peer_mss )
+{
+  const uint64_t mss = clamp( uint64_t { peer_mss }, uint64_t { 1 }, uint64_t { advertised_mss_ } );
+  if ( mss == mss_ ) {
+    return;
+  }
+  mss_ = mss;
+
+  // Normally this happens in the handshake, before any data has gone out, and congestion control can start
+  // over with the new segment size. Otherwise, cut up what is outstanding so that retransmissions fit too.
+  if ( next_seqno_ <= 1 ) {
+    congestion_ = CongestionController::make( congestion_control_, mss_ );
+  } else {
+    resegment_outstanding();
+  }
+}
+
+void TCPSender::set_peer_window_scale( bool offered )
+{
+  // A SYN-ACK may carry the option only if the SYN it answers did (RFC 7323 section 2.2)
+  if ( not offered and not syn_sent_ ) {
+    window_scale_.reset();
+  }
+}
+
+void TCPSender::set_peer_timestamps( bool offered )
+{
+  timestamps_ = timestamps_offered_ and offered;
+  // Likewise, a SYN-ACK carries a timestamp only if the SYN it answers did (RFC 7323 section 3.2)
+  if ( not syn_sent_ ) {
+    timestamps_offered_ = timestamps_;
+  }
+}
+
+void TCPSender::set_cork( bool cork )
+{
+  corked_ = cork;
+}
+
+void TCPSender::resegment_outstanding()
+{
+  deque<OutstandingSegment> resegmented;
+  for ( const auto& seg : outstanding_segments_ ) {
+    if ( seg.payload_size <= mss_ ) {
+      resegmented.push_back( seg );
+      continue;
+    }
+    for ( uint64_t offset = 0; offset < seg.payload_size; offset += mss_ ) {
+      OutstandingSegment piece = seg;
+      piece.start = seg.start + offset;
+      piece.payload_size = min( mss_, seg.payload_size - offset );
+      piece.FIN = seg.FIN and offset + piece.payload_size == seg.payload_size;
+      resegmented.push_back( piece );
+    }
+  }
+  outstanding_segments_ = move( resegmented );
 }
 
 TCPSenderMessage TCPSender::send_empty_message() const
@@ -121,12 +577,22 @@ TCPSenderMessage TCPSender::send_empty_message() const
   msg.SYN = false;
   msg.payload = Buffer {};
   msg.FIN = false;
+  add_timestamp( msg );
 
   return msg;
 }
 
+void TCPSender::add_timestamp( TCPSenderMessage& msg ) const
+{
+  // Our timestamp clock is the sender's millisecond clock
+  if ( msg.SYN ? timestamps_offered_ : timestamps_ ) {
+    msg.timestamp = static_cast<uint32_t>( time_elapsed_ );
+  }
+}
+
 void TCPSender::receive( const TCPReceiverMessage& msg )
 {
+  const bool window_changed = msg.window_size != receiver_window_size_;
   receiver_window_size_ = msg.window_size;
 
   if ( !msg.ackno.has_value() ) {
@@ -135,39 +601,139 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
   uint64_t ackno = msg.ackno.value().unwrap( isn_, next_seqno_ );
 
-  // Ignore if ackno doesn't acknowledge new data or is impossible (beyond next_seqno)
-  if ( ackno <= ackd_seqno_ || ackno > next_seqno_ ) {
+  // Ignore an impossible ackno (beyond next_seqno)
+  if ( ackno > next_seqno_ ) {
+    return;
+  }
+
+  // An ack that doesn't acknowledge new data may still selectively acknowledge some. And one that repeats the
+  // last ack while data is outstanding (and isn't just a window update) means a segment after the acked data
+  // arrived.
+  if ( ackno <= ackd_seqno_ ) {
+    update_scoreboard( msg.sack );
+    if ( fast_retransmit_ and receiver_has_ackno_ and ackno == ackd_seqno_ and bytes_in_flight_ > 0
+         and not window_changed ) {
+      receive_duplicate_ack();
+    }
+    rack_detect_losses();
     return;
   }
 
+  const uint64_t newly_acked = ackno - ackd_seqno_;
+  const uint64_t bytes_in_flight_before = bytes_in_flight_;
+
   // Update acknowledged sequence number
   ackd_seqno_ = ackno;
   receiver_has_ackno_ = true;
 
-  // Remove acknowledged segments from outstanding queue
-  queue<TCPSenderMessage> new_outstanding;
-  queue<uint64_t> new_timestamps;
-
-  while ( !outstanding_segments_.empty() ) {
-    const auto& seg = outstanding_segments_.front();
-    uint64_t seg_start = seg.seqno.unwrap( isn_, ackd_seqno_ );
-    uint64_t seg_end = seg_start + seg.sequence_length();
-
-    if ( seg_end <= ackno ) {
-      // This segment is fully acknowledged
-      bytes_in_flight_ -= seg.sequence_length();
-      outstanding_segments_.pop();
+  // Remove the acknowledged prefix of the outstanding segments, noting the last one sent that wasn't
+  // retransmitted, and whether the ack covers any retransmitted data (by Karn's rule, the ack is then no
+  // unambiguous round-trip time: it may have been prompted by the retransmission, long after the segments
+  // behind it were sent). A segment the ack covers only part of is trimmed to its unacked part, which is all a
+  // retransmission of it will carry.
+  bytes_in_flight_ -= newly_acked;
+  optional<OutstandingSegment> sampled;
+  bool retransmission_acked = false;
+  while ( not outstanding_segments_.empty() and outstanding_segments_.front().end() <= ackno ) {
+    auto& seg = outstanding_segments_.front();
+    if ( seg.sacked ) {
+      sacked_bytes_ -= seg.sequence_length();
+    }
+    if ( seg.retransmitted ) {
+      retransmission_acked = true;
     } else {
-      // This segment is not fully acknowledged, keep it
-      new_outstanding.push( seg );
-      outstanding_segments_.pop();
+      sampled = seg;
+    }
+    rack_update( seg );
+    outstanding_segments_.pop_front();
+  }
+  if ( not outstanding_segments_.empty() and outstanding_segments_.front().start < ackno ) {
+    auto& seg = outstanding_segments_.front();
+    const uint64_t trimmed = ackno - seg.start;
+    retransmission_acked |= seg.retransmitted;
+    if ( seg.sacked ) {
+      sacked_bytes_ -= trimmed;
     }
+    seg.payload_size -= trimmed - seg.SYN;
+    seg.SYN = false;
+    seg.start = ackno;
+  }
+  send_buffer_.release_before( outstanding_segments_.empty() ? next_seqno_
+                                                             : outstanding_segments_.front().stream_index() );
+
+  update_scoreboard( msg.sack );
+
+  // The timestamp echo times the transmission that prompted this ack, even a retransmission. Without it,
+  // only an ack of segments that were all sent once can be timed.
+  optional<uint64_t> rtt_ms;
+  if ( timestamps_ and msg.timestamp_echo.has_value() ) {
+    rtt_ms = static_cast<uint32_t>( static_cast<uint32_t>( time_elapsed_ ) - msg.timestamp_echo.value() );
+  } else if ( sampled.has_value() and not retransmission_acked ) {
+    rtt_ms = time_elapsed_ - sampled->sent_ms;
+  }
+  if ( rtt_ms.has_value() and estimate_rto_ ) {
+    rtt_.add_sample( rtt_ms.value() );
   }
 
-  outstanding_segments_ = move( new_outstanding );
+  // Take a delivery-rate sample (over the longer of the send and ack intervals, so neither compression of
+  // the sends nor of the acks inflates it)
+  delivered_ += newly_acked;
+  delivered_ms_ = time_elapsed_;
+  if ( sampled.has_value() ) {
+    first_sent_ms_ = sampled->sent_ms;
+    const uint64_t interval
+      = max( { sampled->sent_ms - sampled->first_sent_ms, time_elapsed_ - sampled->delivered_ms, uint64_t { 1 } } );
+    const double rate = static_cast<double>( delivered_ - sampled->delivered ) / static_cast<double>( interval );
+    const RateSample sample { rate,
+                              time_elapsed_ - sampled->sent_ms,
+                              sampled->delivered,
+                              delivered_,
+                              sampled->app_limited };
+    congestion_->on_rate_sample( sample, time_elapsed_ );
+  }
 
-  // Reset RTO and restart timer if we have outstanding data
-  current_RTO_ms_ = initial_RTO_ms_;
+  // Outside recovery, let congestion control grow the window
+  duplicate_acks_ = 0;
+  if ( not in_fast_recovery_ ) {
+    congestion_->on_ack( newly_acked, bytes_in_flight_before, time_elapsed_ );
+  } else if ( ackno < recover_ and receiver_sacks_ ) {
+    // A partial ack: the data it now points at was sent before the retransmission that just arrived, so it
+    // is lost too. Then repair whatever else the scoreboard says is missing.
+    if ( ackno >= high_retransmitted_ ) {
+      retransmit_first_outstanding();
+      high_retransmitted_ = outstanding_segments_.front().end();
+    }
+    retransmit_sacked_holes();
+  } else if ( ackno < recover_ ) {
+    // A partial ack: the next hole is lost too, so repair it now. Deflate the window by what left the
+    // network, less the segment that may take its place.
+    retransmit_first_outstanding();
+    window_inflation_ -= min( window_inflation_, newly_acked );
+    if ( newly_acked >= mss_ ) {
+      window_inflation_ += mss_;
+    }
+  } else {
+    // Everything that was in flight when recovery began has arrived: back to the (reduced) congestion window
+    in_fast_recovery_ = false;
+    window_inflation_ = 0;
+  }
+
+  // If the tail loss probe is acked without recovery having begun, the probe may have repaired a loss by itself
+  // (with no duplicate SACK to say the segment arrived twice, there's no telling), so congestion control hears
+  // of one
+  if ( probe_end_ > 0 and ackno >= probe_end_ ) {
+    congestion_->on_loss( bytes_in_flight_before, time_elapsed_ );
+    probe_end_ = 0;
+  }
+  rack_detect_losses();
+
+  // Reset RTO and restart timer if we have outstanding data. With estimation on, a backed-off timeout
+  // stays in force until there's a new RTT sample (Karn's rule again).
+  if ( not estimate_rto_ ) {
+    current_RTO_ms_ = initial_RTO_ms_;
+  } else if ( rtt_ms.has_value() ) {
+    current_RTO_ms_ = rtt_.rto_ms();
+  }
   consecutive_retx_ = 0;
 
   if ( !outstanding_segments_.empty() ) {
@@ -175,20 +741,52 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   } else {
     stop_timer();
   }
+  arm_probe_timer();
 }
 
 void TCPSender::tick( const size_t ms_since_last_tick )
 {
   time_elapsed_ += ms_since_last_tick;
 
+  if ( reorder_timer_until_ > 0 and time_elapsed_ >= reorder_timer_until_ ) {
+    rack_detect_losses();
+  }
+
+  // The tail loss probe: send the last segment again, to draw out a SACK (or a duplicate ack) of it that shows
+  // what's missing before it. The retransmission timer starts over, and no other probe goes until it's acked.
+  if ( probe_timer_until_ > 0 and time_elapsed_ >= probe_timer_until_ and not outstanding_segments_.empty()
+       and not in_fast_recovery_ ) {
+    probe_timer_until_ = 0;
+    probe_end_ = next_seqno_;
+    retransmit( outstanding_segments_.back() );
+    timer_running_until_ = time_elapsed_ + current_RTO_ms_;
+  }
+
   if ( timer_expired() && !outstanding_segments_.empty() ) {
     // Retransmit the earliest outstanding segment
-    TCPSenderMessage msg = outstanding_segments_.front();
-    messages_to_send_.push( msg );
+    retransmit_first_outstanding();
 
     if ( receiver_window_size_ > 0 ) {
+      // A timeout is a sign of heavy congestion (but a timer backing off again says nothing new)
+      if ( consecutive_retx_ == 0 ) {
+        congestion_->on_rto( bytes_in_flight_, time_elapsed_ );
+      }
+      in_fast_recovery_ = false;
+      window_inflation_ = 0;
+      duplicate_acks_ = 0;
+      recover_ = next_seqno_;
+      // The receiver may have discarded data it selectively acked (RFC 2018 reneging), so the scoreboard
+      // starts over from the SACK blocks that arrive from now on
+      for ( auto& seg : outstanding_segments_ ) {
+        seg.sacked = false;
+      }
+      sacked_bytes_ = 0;
+      high_retransmitted_ = 0;
+      probe_timer_until_ = 0;
+      probe_end_ = 0;
       consecutive_retx_++;
-      current_RTO_ms_ *= 2; // Exponential backoff
+      // Exponential backoff
+      current_RTO_ms_ = estimate_rto_ ? rtt_.backed_off( current_RTO_ms_ ) : current_RTO_ms_ * 2;
     }
 
     // Restart timer
@@ -219,5 +817,11 @@ uint64_t TCPSender::window_size() const
   if ( receiver_window_size_ == 0 ) {
     return 1; // Special case: treat zero window as size 1 for probing
   }
-  return receiver_window_size_;
+
+  // In recovery the window is inflated by the segments that have since left the network; before it, limited
+  // transmit lets a new segment out on each of the first two duplicate acks
+  const uint64_t extra = in_fast_recovery_ ? window_inflation_ : min( duplicate_acks_, uint64_t { 2 } ) * mss_;
+  const uint64_t cwnd = congestion_->cwnd();
+  const uint64_t congestion_limit = cwnd > numeric_limits<uint64_t>::max() - extra ? cwnd : cwnd + extra;
+  return min( static_cast<uint64_t>( receiver_window_size_ ), congestion_limit );
 }
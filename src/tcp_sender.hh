@@ -1,22 +1,50 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "rtt_estimator.hh"
+#include "send_buffer.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <deque>
+#include <memory>
 #include <queue>
+#include <vector>
 
 class TCPSender
 {
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
 
+  // Segment size: we advertise our own MSS on our SYN, and send no more than the peer advertises on its own
+  uint16_t advertised_mss_;
+  uint64_t mss_;
+
+  // Window scale offered on our SYN, if any: how far our side will shift the windows it advertises. A SYN-ACK
+  // carries it only if the peer's SYN offered window scaling too.
+  std::optional<uint8_t> window_scale_;
+
+  // Segmentation offload: push() may put up to MAX_OFFLOAD_SIZE bytes in one message, which the adapter splits
+  // into MSS-sized packets. It's still tracked (and retransmitted) as MSS-sized outstanding segments.
+  bool segmentation_offload_;
+
+  // Coalescing small writes: Nagle's algorithm holds back a less-than-full segment while data is in flight, and
+  // corking holds it back until uncorked. Neither holds back the end of the stream.
+  bool nagle_;
+  bool corked_ { false };
+
   // TCP sender state
   uint64_t next_seqno_ { 0 };          // Next sequence number to send
   uint64_t bytes_in_flight_ { 0 };     // Number of sequence numbers outstanding
   uint64_t ackd_seqno_ { 0 };          // Last acknowledged sequence number
-  uint16_t receiver_window_size_ { 1 }; // Receiver's advertised window size
+  uint32_t receiver_window_size_ { 1 }; // Receiver's advertised window size
   bool receiver_has_ackno_ { false };   // Whether we've received an ackno from receiver
+
+  // Congestion control: limits what is in flight alongside the receiver's window
+  CongestionControl congestion_control_;
+  std::unique_ptr<CongestionController> congestion_;
   
   // SYN and FIN tracking
   bool syn_sent_ { false };
@@ -27,23 +55,105 @@ class TCPSender
   uint64_t timer_running_until_ { 0 }; // When the timer expires (0 = not running)
   uint64_t time_elapsed_ { 0 };        // Total time elapsed since construction
   uint64_t consecutive_retx_ { 0 };    // Number of consecutive retransmissions
-  
-  // Outstanding segments (for retransmission)
-  std::queue<TCPSenderMessage> outstanding_segments_;
-  // std::queue<uint64_t> outstanding_timestamps_; // When each segment was sent
-  
+
+  // Fast retransmit and fast recovery (RFC 5681, with RFC 6582's handling of partial acks and RFC 3042's
+  // limited transmit). These are part of congestion control, so they're off without it.
+  bool fast_retransmit_;
+  uint64_t duplicate_acks_ { 0 };   // Duplicate acks in a row
+  bool in_fast_recovery_ { false }; // Whether we're repairing a loss that three duplicate acks signalled
+  uint64_t recover_ { 0 };          // next_seqno_ when the last recovery (or timeout) began
+  uint64_t window_inflation_ { 0 }; // How far recovery has opened the window past the congestion window
+
+  // Selective acknowledgments (RFC 2018): if the receiver reports them, recovery follows RFC 6675's
+  // scoreboard, retransmitting only the holes and counting what is really still in the network
+  bool sack_enabled_;                 // Whether we offered SACK on our SYN
+  bool receiver_sacks_ { false };     // Whether the receiver has sent any SACK blocks
+  uint64_t sacked_bytes_ { 0 };       // Outstanding sequence numbers the receiver has selectively acked
+  uint64_t high_retransmitted_ { 0 }; // In SACK recovery, where the holes retransmitted so far end
+
+  // Round-trip time estimation (if off, every ack of new data resets the timeout to initial_RTO_ms_)
+  bool estimate_rto_;
+  RTTEstimator rtt_;
+
+  // Timestamps (RFC 7323): offered on our SYN (on a SYN-ACK, only if the peer's SYN offered them), and sent on
+  // every segment if the peer's SYN offered them too.
+  // Every ack of new data then echoes the transmission it answers, retransmission or not, for an RTT sample.
+  bool timestamps_offered_;
+  bool timestamps_ { false };
+
+  // RACK-TLP (RFC 8985): time-based loss detection, from when each segment was last sent, and tail loss probes
+  bool rack_tlp_;
+  uint64_t rack_xmit_ms_ { 0 };             // When the most recently sent of the delivered segments was sent
+  uint64_t rack_end_ { 0 };                 // Where that segment ends (to order segments sent in the same ms)
+  std::optional<uint64_t> rack_rtt_ {};     // That segment's round-trip time
+  std::optional<uint64_t> rack_min_rtt_ {}; // Smallest round-trip time of a segment that wasn't retransmitted
+  uint64_t reorder_timer_until_ { 0 };      // When to look for losses again (0 = not running)
+  uint64_t probe_timer_until_ { 0 };        // When to send a tail loss probe (0 = not running)
+  uint64_t probe_end_ { 0 };                // next_seqno_ when the unanswered probe went (0 = none)
+
+  // Outstanding segments in sequence order, each tagged with where it lies in the absolute sequence space (so
+  // an ack only has to look at the front) and with what's needed to take a delivery-rate sample when acked.
+  // Their payloads live (once) in the send buffer, from which retransmissions are built: a segment about to be
+  // retransmitted first takes in the unsacked data after it, up to an MSS.
+  struct OutstandingSegment
+  {
+    uint64_t start;         // Absolute sequence number of its first byte
+    uint64_t payload_size;  // Bytes of the stream it carries
+    bool SYN;               // Whether it carries the SYN
+    bool FIN;               // Whether it carries the FIN
+    uint64_t sent_ms;       // When it was last sent
+    uint64_t first_sent_ms; // first_sent_ms_ when it was sent
+    uint64_t delivered;     // delivered_ when it was sent
+    uint64_t delivered_ms;  // delivered_ms_ when it was sent
+    bool app_limited;       // Whether the stream had run dry when it was sent
+    bool retransmitted {};
+    bool sacked {}; // Whether the receiver has selectively acked it
+
+    uint64_t sequence_length() const { return SYN + payload_size + FIN; }
+    uint64_t end() const { return start + sequence_length(); }
+    uint64_t stream_index() const { return start + SYN - 1; } // Stream index of its first payload byte
+  };
+  std::deque<OutstandingSegment> outstanding_segments_ {};
+  SendBuffer send_buffer_ {}; // The outstanding segments' payloads
+
+  // Delivery-rate sampling (as in draft-cheng-iccrg-delivery-rate-estimation)
+  uint64_t delivered_ { 0 };     // Sequence numbers acknowledged so far
+  uint64_t delivered_ms_ { 0 };  // When delivered_ last grew
+  uint64_t first_sent_ms_ { 0 }; // When the segment behind the latest sample was sent
+
+  // Pacing: new data goes out no faster than the congestion controller's pacing rate, if it has one
+  double next_release_ms_ { 0 }; // When the pacer will next let new data out
+  bool held_by_pacer_ { false }; // Whether the last push() left data waiting for the pacer
+
   // Messages ready to send
-  std::queue<TCPSenderMessage> messages_to_send_;
+  std::queue<TCPSenderMessage> messages_to_send_ {};
 
   // Helper methods
+  void transmit( TCPSenderMessage msg, const Reader& outbound_stream );
+  TCPSenderMessage make_message( const OutstandingSegment& seg ) const;
+  void retransmit( OutstandingSegment& seg );
+  template<typename Mergeable>
+  OutstandingSegment& coalesce( size_t index, Mergeable mergeable );
+  void retransmit_first_outstanding();
+  void receive_duplicate_ack();
+  void enter_fast_recovery();
+  void update_scoreboard( const std::vector<SACKBlock>& blocks );
+  void retransmit_sacked_holes();
+  void rack_update( const OutstandingSegment& seg );
+  void rack_detect_losses();
+  void arm_probe_timer();
+  void resegment_outstanding();
+  bool pacer_ready() const;
+  bool hold_small_segment( const Reader& outbound_stream ) const;
+  void add_timestamp( TCPSenderMessage& msg ) const;
   void start_timer_if_needed();
   void stop_timer();
   bool timer_expired() const;
   uint64_t window_size() const;
 
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
+  /* Construct TCP sender with the config's initial Retransmission Timeout, possible ISN and congestion control */
+  explicit TCPSender( const TCPConfig& config );
 
   /* Push bytes from the outbound stream */
   void push( Reader& outbound_stream );
@@ -51,16 +161,38 @@ public:
   /* Send a TCPSenderMessage if needed (or empty optional otherwise) */
   std::optional<TCPSenderMessage> maybe_send();
 
+  /* If the pacer is holding back data, how many milliseconds until push() will send more of it? */
+  std::optional<uint64_t> next_send_time() const;
+
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage send_empty_message() const;
 
   /* Receive an act on a TCPReceiverMessage from the peer's receiver */
   void receive( const TCPReceiverMessage& msg );
 
+  /* The peer's SYN advertised the largest payload it will accept (the MSS option) */
+  void set_peer_mss( uint16_t peer_mss );
+
+  /* The peer's SYN did (or didn't) offer window scaling */
+  void set_peer_window_scale( bool offered );
+
+  /* The peer's SYN did (or didn't) offer timestamps */
+  void set_peer_timestamps( bool offered );
+
+  /* Like TCP_CORK: while corked, send only full segments (and the end of the stream); push() after uncorking */
+  void set_cork( bool cork );
+
   /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
   void tick( uint64_t ms_since_last_tick );
 
   /* Accessors for use in testing */
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t congestion_window() const;           // How many sequence numbers may congestion control have in flight?
+  uint64_t slow_start_threshold() const;        // Below this congestion window, the window grows exponentially
+  const RTTEstimator& rtt_estimator() const;    // Smoothed round-trip time, its variation, and the timeout
+  uint64_t mss() const;                         // The largest payload the sender will put in a segment
+  bool segmentation_offload() const;            // Whether messages may carry many segments' worth of payload
+  bool corked() const;                          // Whether less-than-full segments are being held back
+  bool timestamps() const;                      // Whether both sides agreed to timestamps
 };
@@ -1,8 +1,11 @@
 #include "byte_stream.hh"
 #include "byte_stream_test_harness.hh"
 
+#include <climits>
 #include <exception>
 #include <iostream>
+#include <memory>
+#include <string>
 
 using namespace std;
 
@@ -68,6 +71,184 @@ int main()
       test.execute( AvailableCapacity { 0 } );
       test.execute( BytesBuffered { 2 } );
       test.execute( Peek { "at" } );
+      test.execute( PeekOnce { "a" } );
+      test.execute( PeekAll { "at" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve-commit-wrap", 3 };
+
+      test.execute( PushReserved { "cat" } );
+      test.execute( BytesPushed { 3 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Pop { 2 } );
+      test.execute( PushReserved { "ow!" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "t" } );
+      test.execute( Peek { "tow" } );
+      test.execute( PushReserved { "" } );
+      test.execute( Close {} );
+      test.execute( PushReserved { "x" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( ReadAll { "tow" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "rope-slices", 8, ByteStream::Storage::Rope };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "dog" } );
+      test.execute( Push { "emu" } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( PeekAll { "catdogem" } );
+      test.execute( Pop { 1 } );
+      test.execute( PopBuffers { 4, { "at", "do" } } );
+      test.execute( BytesPopped { 5 } );
+      test.execute( PushReserved { "mouse" } );
+      test.execute( BytesPushed { 13 } );
+      test.execute( PopBuffers { 100, { "g", "em", "mouse" } } );
+      test.execute( BufferEmpty { true } );
+      test.execute( PopBuffers { 1, {} } );
+    }
+
+    {
+      ByteStreamTestHarness test { "rope-owns-pushed-bytes", 8, ByteStream::Storage::Rope };
+
+      test.execute( PushBufferThenRelease { "cat" } );
+      test.execute( PushBufferThenRelease { "dog" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAll { "atdog" } );
+      test.execute( PopBuffers { 5, { "at", "dog" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "rope-peek-all-fits-writev", 2 * IOV_MAX, ByteStream::Storage::Rope };
+
+      for ( int i = 0; i < 2 * IOV_MAX; ++i ) {
+        test.execute( Push { "x" } );
+      }
+      test.execute( PeekAllViews { IOV_MAX } );
+      test.execute( Pop { IOV_MAX } );
+      test.execute( PeekAllViews { IOV_MAX } );
+      test.execute( Pop { IOV_MAX } );
+      test.execute( PeekAllViews { 0 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "rope-reserve-chunk", 1000000, ByteStream::Storage::Rope };
+
+      test.execute( PushReserved { string( 4999, 'y' ) } );
+      test.execute( BytesPushed { 4096 } );
+      test.execute( PushReserved { string( 1000, 'z' ) } );
+      test.execute( BytesPushed { 5096 } );
+      test.execute( ReadAll { string( 4096, 'y' ) + string( 1000, 'z' ) } );
+    }
+
+    {
+      ByteStreamTestHarness test { "flat-pop-buffers", 4 };
+
+      test.execute( Push { "cat" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "dog" } );
+      test.execute( PopBuffers { 3, { "tdo" } } );
+      test.execute( Peek { "g" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "lazy-allocation", 1000000 };
+
+      test.execute( MemoryFootprint { 0 } );
+      test.execute( AvailableCapacity { 1000000 } );
+      test.execute( Push { "cat" } );
+      test.execute( MemoryFootprint { 4096 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( MemoryFootprint { 8192 } );
+      test.execute( AvailableCapacity { 1000000 - 5003 } );
+      test.execute( Pop { 5000 } );
+      test.execute( Peek { "xxx" } );
+      test.execute( ShrinkToFit {} );
+      test.execute( MemoryFootprint { 4096 } );
+      test.execute( Peek { "xxx" } );
+      test.execute( Pop { 3 } );
+      test.execute( ShrinkToFit {} );
+      test.execute( MemoryFootprint { 0 } );
+      test.execute( Push { "dog" } );
+      test.execute( ReadAll { "dog" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "lazy-allocation-capped", 5000 };
+
+      test.execute( PushReserved { string( 4999, 'y' ) } );
+      test.execute( BytesPushed { 4096 } );
+      test.execute( PushReserved { string( 1000, 'z' ) } );
+      test.execute( BytesPushed { 5000 } );
+      test.execute( MemoryFootprint { 5000 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Pop { 4999 } );
+      test.execute( Peek { "z" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "set-capacity", 5000 };
+
+      test.execute( Push { string( 5000, 'y' ) } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( SetCapacity { 20000 } );
+      test.execute( AvailableCapacity { 15000 } );
+      test.execute( Push { string( 10000, 'z' ) } );
+      test.execute( BytesBuffered { 15000 } );
+      test.execute( AvailableCapacity { 5000 } );
+
+      // It can't shrink below what is buffered
+      test.execute( SetCapacity { 100 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Pop { 14000 } );
+      test.execute( AvailableCapacity { 14000 } );
+      test.execute( SetCapacity { 100 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Pop { 1000 } );
+      test.execute( AvailableCapacity { 1000 } );
+      test.execute( SetCapacity { 100 } );
+      test.execute( AvailableCapacity { 100 } );
+      test.execute( ShrinkToFit {} );
+      test.execute( MemoryFootprint { 0 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "low-watermark", 10 };
+      const auto log = make_shared<string>();
+
+      test.execute( WatchWritable { log } );
+      test.execute( SetLowWatermark { 4 } );
+      test.execute( AvailableCapacity { 10 } );
+      test.execute( Push { "ab" } );
+      test.execute( AvailableCapacity { 8 } );
+      test.execute( WritableChanges { log, "" } );
+      test.execute( Push { "cdef" } );
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( WritableChanges { log, "-" } );
+      test.execute( Push { "g" } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( Pop { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( WritableChanges { log, "-" } );
+      test.execute( Pop { 1 } );
+      test.execute( AvailableCapacity { 7 } );
+      test.execute( WritableChanges { log, "-+" } );
+      test.execute( Push { "ghijklmnop" } );
+      test.execute( BytesBuffered { 10 } );
+      test.execute( WritableChanges { log, "-+-" } );
+      test.execute( SetLowWatermark { 100 } );
+      test.execute( WritableChanges { log, "-+-" } );
+      test.execute( Pop { 1 } );
+      test.execute( AvailableCapacity { 1 } );
+      test.execute( WritableChanges { log, "-+-+" } );
     }
 
     {
@@ -15,7 +15,8 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage = ByteStream::Storage::Flat )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -34,7 +35,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -75,8 +76,9 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  cout << "ByteStream with capacity=" << capacity
+       << ( storage == ByteStream::Storage::Mirrored ? " (mirrored)" : "" ) << ", write_size=" << write_size
+       << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
   debug_output << "             ByteStream throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
@@ -89,6 +91,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Mirrored );
 }
 
 int main()
@@ -4,8 +4,10 @@
 #include "common.hh"
 
 #include <concepts>
+#include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -16,10 +18,26 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Flat )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + storage_description( storage ),
+                   ByteStream { capacity, storage } )
   {}
 
+  static std::string storage_description( ByteStream::Storage storage )
+  {
+    switch ( storage ) {
+      case ByteStream::Storage::Mirrored:
+        return ", mirrored";
+      case ByteStream::Storage::Rope:
+        return ", rope";
+      default:
+        return "";
+    }
+  }
+
   size_t peek_size() { return object().reader().peek().size(); }
 };
 
@@ -34,6 +52,136 @@ struct Push : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.writer().push( data_ ); }
 };
 
+struct PushReserved : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit PushReserved( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "write \"" + Printer::prettify( data_ ) + "\" into reserve() and commit";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    std::string_view remaining = data_;
+    uint64_t written = 0;
+    for ( const auto region : bs.writer().reserve() ) {
+      const auto chunk = remaining.substr( 0, region.size() );
+      std::copy( chunk.begin(), chunk.end(), region.begin() );
+      remaining.remove_prefix( chunk.size() );
+      written += chunk.size();
+    }
+    bs.writer().commit( written );
+  }
+};
+
+struct PushBufferThenRelease : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit PushBufferThenRelease( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "push Buffer \"" + Printer::prettify( data_ ) + "\", then overwrite and release it";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    Buffer buffer { data_ };
+    bs.writer().push( buffer );
+    static_cast<std::string&>( buffer ).assign( data_.size(), 'x' );
+    std::string released = buffer.release();
+    released.clear();
+  }
+};
+
+struct PopBuffers : public Expectation<ByteStream>
+{
+  size_t len_;
+  std::vector<std::string> output_;
+
+  PopBuffers( size_t len, std::vector<std::string> output ) : len_( len ), output_( move( output ) ) {}
+
+  std::string description() const override
+  {
+    std::string pieces;
+    for ( const auto& x : output_ ) {
+      pieces += ( pieces.empty() ? "\"" : ", \"" ) + Printer::prettify( x ) + "\"";
+    }
+    return "pop_buffers( " + std::to_string( len_ ) + " ) gives [" + pieces + "]";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto got = bs.reader().pop_buffers( len_ );
+    if ( got.size() != output_.size() ) {
+      throw ExpectationViolation { "Expected " + std::to_string( output_.size() )
+                                   + " Buffers from pop_buffers(), but got " + std::to_string( got.size() ) };
+    }
+    for ( size_t i = 0; i < got.size(); ++i ) {
+      if ( std::string_view { got[i] } != output_[i] ) {
+        throw ExpectationViolation { "Expected Buffer \"" + Printer::prettify( output_[i] )
+                                     + "\" from pop_buffers(), but got \"" + Printer::prettify( got[i] )
+                                     + "\"" };
+      }
+    }
+  }
+};
+
+struct ShrinkToFit : public Action<ByteStream>
+{
+  std::string description() const override { return "shrink_to_fit"; }
+  void execute( ByteStream& bs ) const override { bs.shrink_to_fit(); }
+};
+
+struct SetCapacity : public Action<ByteStream>
+{
+  uint64_t capacity_;
+
+  explicit SetCapacity( uint64_t capacity ) : capacity_( capacity ) {}
+  std::string description() const override { return "set_capacity( " + std::to_string( capacity_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.set_capacity( capacity_ ); }
+};
+
+struct SetLowWatermark : public Action<ByteStream>
+{
+  uint64_t bytes_;
+
+  explicit SetLowWatermark( uint64_t bytes ) : bytes_( bytes ) {}
+  std::string description() const override { return "set_low_watermark( " + std::to_string( bytes_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.writer().set_low_watermark( bytes_ ); }
+};
+
+// Records each writability change reported to the Writer's callback as '+' (writable) or '-' (not)
+using WritableLog = std::shared_ptr<std::string>;
+
+struct WatchWritable : public Action<ByteStream>
+{
+  WritableLog log_;
+
+  explicit WatchWritable( WritableLog log ) : log_( move( log ) ) {}
+  std::string description() const override { return "set_writable_callback"; }
+  void execute( ByteStream& bs ) const override
+  {
+    bs.writer().set_writable_callback( [log = log_]( bool writable ) { log->push_back( writable ? '+' : '-' ); } );
+  }
+};
+
+struct WritableChanges : public Expectation<ByteStream>
+{
+  WritableLog log_;
+  std::string expected_;
+
+  WritableChanges( WritableLog log, std::string expected ) : log_( move( log ) ), expected_( move( expected ) ) {}
+  std::string description() const override { return "writable callback has reported \"" + expected_ + "\""; }
+  void execute( ByteStream& /* unused */ ) const override
+  {
+    if ( *log_ != expected_ ) {
+      throw ExpectationViolation { "Expected writable callback to report \"" + expected_ + "\", but it reported \""
+                                   + *log_ + "\"" };
+    }
+  }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -107,6 +255,37 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAll : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_all() covers exactly \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto views = bs.reader().peek_all();
+    if ( views.size() > 2 and bs.storage() != ByteStream::Storage::Rope ) {
+      throw ExpectationViolation { "Reader::peek_all() returned more than two views" };
+    }
+
+    std::string got;
+    for ( const auto view : views ) {
+      if ( view.empty() ) {
+        throw ExpectationViolation { "Reader::peek_all() returned an empty string_view" };
+      }
+      got += view;
+    }
+
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" in buffer, "
+                                   + "but peek_all() found \"" + Printer::prettify( got ) + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
@@ -149,6 +328,13 @@ struct AvailableCapacity : public ExpectNumber<ByteStream, uint64_t>
   size_t value( ByteStream& bs ) const override { return bs.writer().available_capacity(); }
 };
 
+struct MemoryFootprint : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "memory_footprint"; }
+  size_t value( ByteStream& bs ) const override { return bs.memory_footprint(); }
+};
+
 struct BytesPushed : public ExpectNumber<ByteStream, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -163,6 +349,13 @@ struct BytesPopped : public ExpectNumber<ByteStream, uint64_t>
   size_t value( ByteStream& bs ) const override { return bs.reader().bytes_popped(); }
 };
 
+struct PeekAllViews : public ExpectNumber<ByteStream, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "peek_all().size()"; }
+  size_t value( ByteStream& bs ) const override { return bs.reader().peek_all().size(); }
+};
+
 struct ReadAll : public Expectation<ByteStream>
 {
   std::string output_;
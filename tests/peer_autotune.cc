@@ -0,0 +1,156 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t CAPACITY = 64000;
+constexpr uint64_t MAX_CAPACITY = 1'000'000;
+constexpr uint64_t RTT = 10; // Each flight takes a tick this long
+
+TCPConfig config( optional<size_t> recv_capacity_max )
+{
+  TCPConfig cfg;
+  cfg.recv_capacity = CAPACITY;
+  cfg.recv_capacity_max = recv_capacity_max;
+  return cfg;
+}
+
+// For a number of round trips, the client sends as fast as it may, to a server that reads everything at once
+// (if `read`). Returns the most the client had in flight.
+uint64_t transfer( TCPPeer& client, TCPPeer& server, int round_trips, bool read = true )
+{
+  uint64_t most_in_flight = 0;
+  vector<TCPSegment> data; // What the client sent in reply to the last round trip's acks
+  for ( int i = 0; i < round_trips; ++i ) {
+    Writer& writer = client.outbound_writer();
+    writer.push( string( writer.available_capacity(), 'x' ) );
+    client.push();
+    for ( auto& seg : collect( client ) ) {
+      data.push_back( move( seg ) );
+    }
+    auto acks = deliver( move( data ), server );
+    most_in_flight = max( most_in_flight, client.sender().sequence_numbers_in_flight() );
+    if ( read ) {
+      server.inbound_reader().pop( server.inbound_reader().bytes_buffered() );
+    }
+    tick( client, server, RTT );
+    data = deliver( move( acks ), client );
+  }
+
+  // The last flight lands too, leaving the server's acks of it to be sent
+  for ( auto& seg : data ) {
+    server.receive( over_the_wire( move( seg ) ) );
+  }
+  return most_in_flight;
+}
+
+// Until neither side has anything to send, the client sends what it may, and the server reads it and acks
+void settle( TCPPeer& client, TCPPeer& server )
+{
+  while ( true ) {
+    const size_t sent = deliver( client, server );
+    server.inbound_reader().pop( server.inbound_reader().bytes_buffered() );
+    const size_t acks = deliver( server, client );
+    if ( sent == 0 and acks == 0 ) {
+      break;
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // The receive capacity keeps ahead of a sender that the application keeps up with, up to the limit
+      TCPPeer client { config( nullopt ) };
+      TCPPeer server { config( MAX_CAPACITY ) };
+      connect( client, server, RTT );
+      const uint64_t most_in_flight = transfer( client, server, 30 );
+      const uint64_t capacity = server.inbound_reader().capacity();
+      check( capacity > CAPACITY, "the receive capacity didn't grow" );
+      check( capacity <= MAX_CAPACITY, "the receive capacity grew past its limit" );
+      check( most_in_flight > CAPACITY, "the sender wasn't let past the starting window" );
+    }
+
+    {
+      // Once the connection idles, the capacity goes back to where it started, but only as the client uses up
+      // the window it was last given: all it sends after the idle time is accepted
+      TCPConfig server_config = config( MAX_CAPACITY );
+      server_config.ack_delay = 0;
+      TCPPeer client { config( nullopt ) };
+      TCPPeer server { server_config };
+      connect( client, server, RTT );
+      transfer( client, server, 30 );
+      settle( client, server );
+      check( server.inbound_reader().capacity() > CAPACITY, "the receive capacity didn't grow" );
+
+      server.tick( TCPConfig::IDLE_SHRINK_DFLT );
+      check( server.inbound_reader().capacity() > CAPACITY, "the receive capacity retracted the window" );
+
+      uint64_t sent = 0;
+      vector<TCPSegment> data;
+      while ( true ) {
+        Writer& writer = client.outbound_writer();
+        writer.push( string( writer.available_capacity(), 'x' ) );
+        client.push();
+        auto segments = collect( client );
+        if ( segments.empty() ) {
+          break;
+        }
+        for ( auto& seg : segments ) {
+          sent += seg.sender_message.payload.size();
+          data.push_back( move( seg ) );
+        }
+      }
+      check( sent > CAPACITY, "the client didn't send the window it was given" );
+      auto acks = deliver( move( data ), server );
+      check( server.inbound_reader().bytes_buffered() == sent, "data inside the advertised window was dropped" );
+      for ( auto& ack : acks ) {
+        client.receive( over_the_wire( move( ack ) ) );
+      }
+
+      settle( client, server );
+      check( server.inbound_reader().bytes_popped() == client.outbound_writer().bytes_pushed(), "data lost" );
+      check( server.inbound_reader().capacity() == CAPACITY, "the receive capacity didn't go back" );
+    }
+
+    {
+      // Without a limit to grow to, the receive capacity stays put
+      TCPPeer client { config( nullopt ) };
+      TCPPeer server { config( nullopt ) };
+      connect( client, server, RTT );
+      const uint64_t most_in_flight = transfer( client, server, 30 );
+      check( server.inbound_reader().capacity() == CAPACITY, "the receive capacity changed" );
+      check( most_in_flight <= CAPACITY, "the sender went past the receive window" );
+    }
+
+    {
+      // An application that doesn't read doesn't earn a bigger buffer
+      TCPPeer client { config( nullopt ) };
+      TCPPeer server { config( MAX_CAPACITY ) };
+      connect( client, server, RTT );
+      transfer( client, server, 30, false );
+      check( server.inbound_reader().capacity() == CAPACITY, "the receive capacity grew without reads" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+TCPConfig config( uint64_t ack_delay = TCPConfig::ACK_DELAY_DFLT )
+{
+  TCPConfig cfg;
+  cfg.ack_delay = ack_delay;
+  return cfg;
+}
+
+// The client sends `data`; returns its segments, not yet delivered
+vector<TCPSegment> client_sends( TCPPeer& client, const string& data )
+{
+  client.outbound_writer().push( data );
+  auto segments = collect( client );
+  check( not segments.empty(), "client sent nothing" );
+  return segments;
+}
+
+// Hand each segment to the server in turn, returning how many segments it sent in reply
+size_t acks_for( TCPPeer& server, vector<TCPSegment> segments )
+{
+  return deliver( move( segments ), server ).size();
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // In-order full segments are acked every second one
+      TCPPeer client { config() };
+      TCPPeer server { config() };
+      connect( client, server );
+      const auto segments = client_sends( client, string( 6 * TCPConfig::MAX_PAYLOAD_SIZE, 'x' ) );
+      check( segments.size() == 6, "expected six segments" );
+      check( acks_for( server, segments ) == 3, "not one ack per two segments" );
+    }
+
+    {
+      // Without the delay, each is acked
+      TCPPeer client { config( 0 ) };
+      TCPPeer server { config( 0 ) };
+      connect( client, server );
+      const auto segments = client_sends( client, string( 6 * TCPConfig::MAX_PAYLOAD_SIZE, 'x' ) );
+      check( acks_for( server, segments ) == 6, "not one ack per segment" );
+    }
+
+    {
+      // A lone small segment is acked once the delay is up
+      TCPPeer client { config() };
+      TCPPeer server { config() };
+      connect( client, server );
+      check( acks_for( server, client_sends( client, "hello" ) ) == 0, "small segment acked at once" );
+      server.tick( TCPConfig::ACK_DELAY_DFLT - 1 );
+      check( collect( server ).empty(), "ack sent before the delay was up" );
+      server.tick( 1 );
+      const auto acks = collect( server );
+      check( acks.size() == 1 and acks.front().sender_message.payload.empty(), "no bare ack after the delay" );
+      client.receive( acks.front() );
+      check( client.sender().sequence_numbers_in_flight() == 0, "ack didn't cover the segment" );
+    }
+
+    {
+      // A longer delay than MAX_ACK_DELAY is cut down to it
+      TCPPeer client { config() };
+      TCPPeer server { config( 10 * TCPConfig::MAX_ACK_DELAY ) };
+      connect( client, server );
+      check( acks_for( server, client_sends( client, "hello" ) ) == 0, "small segment acked at once" );
+      server.tick( TCPConfig::MAX_ACK_DELAY - 1 );
+      check( collect( server ).empty(), "ack sent before the delay was up" );
+      server.tick( 1 );
+      check( collect( server ).size() == 1, "ack waited longer than MAX_ACK_DELAY" );
+    }
+
+    {
+      // Data going the other way carries the ack
+      TCPPeer client { config() };
+      TCPPeer server { config() };
+      connect( client, server );
+      check( acks_for( server, client_sends( client, "request" ) ) == 0, "small segment acked at once" );
+      server.outbound_writer().push( string( "response" ) );
+      const auto replies = collect( server );
+      check( replies.size() == 1 and string_view { replies.front().sender_message.payload } == "response",
+             "response not sent alone" );
+      client.receive( replies.front() );
+      check( client.sender().sequence_numbers_in_flight() == 0, "response didn't carry the ack" );
+      server.tick( TCPConfig::ACK_DELAY_DFLT );
+      check( collect( server ).empty(), "ack sent again after the response carried it" );
+    }
+
+    {
+      // Out-of-order data is acked at once, and so is the segment that fills the gap
+      TCPPeer client { config() };
+      TCPPeer server { config() };
+      connect( client, server );
+      auto segments = client_sends( client, string( 3 * TCPConfig::MAX_PAYLOAD_SIZE, 'x' ) );
+      check( segments.size() == 3, "expected three segments" );
+      check( acks_for( server, { segments[1] } ) == 1, "out-of-order segment not acked at once" );
+      check( acks_for( server, { segments[0] } ) == 1, "segment filling the gap not acked at once" );
+      check( acks_for( server, { segments[2] } ) == 0, "in-order segment after the gap not delayed" );
+    }
+
+    {
+      // A FIN is acked at once
+      TCPPeer client { config() };
+      TCPPeer server { config() };
+      connect( client, server );
+      client.outbound_writer().push( string( "bye" ) );
+      client.outbound_writer().close();
+      auto segments = collect( client );
+      check( segments.size() == 1 and segments.front().sender_message.FIN, "expected data with a FIN" );
+      check( acks_for( server, segments ) == 1, "FIN not acked at once" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
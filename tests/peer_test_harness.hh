@@ -0,0 +1,87 @@
+#pragma once
+
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Helpers for tests that connect two TCPPeers back to back, with segments passing through the wire format
+
+inline void check( bool condition, const std::string& what )
+{
+  if ( not condition ) {
+    throw std::runtime_error( what );
+  }
+}
+
+// Serialize a segment and parse it back, as the peer at the other end of a link would see it
+inline TCPSegment over_the_wire( TCPSegment seg )
+{
+  seg.compute_checksum( 0 );
+  TCPSegment parsed;
+  check( parse( parsed, serialize( seg ), 0 ), "segment didn't parse" );
+  return parsed;
+}
+
+// Everything the peer has to send
+inline std::vector<TCPSegment> collect( TCPPeer& peer )
+{
+  std::vector<TCPSegment> segments;
+  while ( auto seg = peer.maybe_send() ) {
+    segments.push_back( std::move( seg.value() ) );
+  }
+  return segments;
+}
+
+// Hand each segment to `to` in turn, returning what it sent in reply (as a peer acking each would)
+inline std::vector<TCPSegment> deliver( std::vector<TCPSegment> segments, TCPPeer& to )
+{
+  std::vector<TCPSegment> replies;
+  for ( auto& seg : segments ) {
+    to.receive( over_the_wire( std::move( seg ) ) );
+    for ( auto& reply : collect( to ) ) {
+      replies.push_back( std::move( reply ) );
+    }
+  }
+  return replies;
+}
+
+// Send everything `from` has to send to `to`, leaving any replies with `to`. Returns how many segments went.
+inline size_t deliver( TCPPeer& from, TCPPeer& to )
+{
+  size_t segments = 0;
+  for ( auto& seg : collect( from ) ) {
+    to.receive( over_the_wire( std::move( seg ) ) );
+    ++segments;
+  }
+  return segments;
+}
+
+inline void tick( TCPPeer& client, TCPPeer& server, uint64_t ms )
+{
+  client.tick( ms );
+  server.tick( ms );
+}
+
+// The three-way handshake, each flight taking `flight_ms` (so that both senders get an RTT sample, if it's not
+// zero). Returns the server's SYN-ACK, as the client saw it.
+inline TCPSegment connect( TCPPeer& client, TCPPeer& server, uint64_t flight_ms = 0 )
+{
+  client.push();
+  auto syn_ack = deliver( collect( client ), server );
+  check( syn_ack.size() == 1 and syn_ack.front().sender_message.SYN, "server didn't reply with a SYN-ACK" );
+  const TCPSegment seen = over_the_wire( syn_ack.front() );
+  tick( client, server, flight_ms );
+  auto ack = deliver( std::move( syn_ack ), client );
+  tick( client, server, flight_ms );
+  check( deliver( std::move( ack ), server ).empty(), "server replied to the handshake's ack" );
+  check( client.has_ackno() and server.has_ackno(), "handshake didn't finish" );
+  check( collect( client ).empty() and collect( server ).empty(), "handshake left segments to send" );
+  return seen;
+}
@@ -0,0 +1,77 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+TCPConfig config( bool timestamps )
+{
+  TCPConfig cfg;
+  cfg.timestamps = timestamps;
+  return cfg;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // The SYN-ACK carries a timestamp only if the SYN offered them
+      TCPPeer client { config( true ) };
+      TCPPeer server { config( true ) };
+      check( connect( client, server ).sender_message.timestamp.has_value(), "SYN-ACK had no timestamp" );
+      check( client.sender().timestamps() and server.sender().timestamps(), "timestamps not agreed" );
+
+      TCPPeer plain_client { config( false ) };
+      TCPPeer timestamp_server { config( true ) };
+      check( not connect( plain_client, timestamp_server ).sender_message.timestamp.has_value(),
+             "SYN-ACK carried a timestamp, but the SYN didn't offer them" );
+      check( not timestamp_server.sender().timestamps(), "timestamps agreed without the client's offer" );
+    }
+
+    {
+      // A delayed ack echoes the earliest segment it covers, so the client's RTT sample includes the delay
+      TCPPeer client { config( true ) };
+      TCPPeer server { config( true ) };
+      connect( client, server );
+      client.outbound_writer().push( string( 100, 'x' ) );
+      check( deliver( client, server ) == 1, "client didn't send" );
+      tick( client, server, TCPConfig::ACK_DELAY_DFLT );
+      check( deliver( server, client ) == 1, "first segment not acked" );
+
+      vector<uint32_t> sent;
+      for ( const string data : { "a", "b" } ) {
+        tick( client, server, 5 );
+        client.outbound_writer().push( data );
+        auto segments = collect( client );
+        check( segments.size() == 1 and segments.front().sender_message.timestamp.has_value(),
+               "expected one segment with a timestamp" );
+        sent.push_back( segments.front().sender_message.timestamp.value() );
+        check( deliver( move( segments ), server ).empty(), "small segment acked at once" );
+      }
+      check( sent.front() != sent.back(), "both segments have the same timestamp" );
+
+      server.tick( TCPConfig::ACK_DELAY_DFLT );
+      const auto acks = collect( server );
+      check( acks.size() == 1, "no ack after the delay" );
+      check( acks.front().receiver_message.timestamp_echo == sent.front(),
+             "ack didn't echo the earliest segment it covers" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
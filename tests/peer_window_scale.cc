@@ -0,0 +1,99 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// The client sends `size` bytes to the server, which reads them as they arrive. Returns the most the client
+// ever had in flight.
+uint64_t transfer( TCPPeer& client, TCPPeer& server, size_t size )
+{
+  connect( client, server );
+
+  const string data( size, 'x' );
+  client.outbound_writer().push( data );
+  client.outbound_writer().close();
+
+  uint64_t max_in_flight = 0;
+  string received;
+  while ( true ) {
+    client.push();
+    max_in_flight = max( max_in_flight, client.sender().sequence_numbers_in_flight() );
+    const size_t sent = deliver( client, server );
+    string chunk;
+    read( server.inbound_reader(), server.inbound_reader().bytes_buffered(), chunk );
+    received += chunk;
+    const size_t acks = deliver( server, client );
+    if ( sent == 0 and acks == 0 ) {
+      break;
+    }
+  }
+  check( received.size() == size, "data lost" );
+  check( server.inbound_reader().is_finished(), "stream didn't finish" );
+  return max_in_flight;
+}
+
+TCPConfig config( bool window_scaling )
+{
+  TCPConfig cfg;
+  cfg.recv_capacity = 1'000'000;
+  cfg.send_capacity = 1'000'000;
+  cfg.congestion_control = CongestionControl::None;
+  cfg.window_scaling = window_scaling;
+  return cfg;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // Both sides offer window scaling: the server's 1 MB window is advertised in full
+      TCPPeer client { config( true ) };
+      TCPPeer server { config( true ) };
+      const uint64_t max_in_flight = transfer( client, server, 900'000 );
+      check( max_in_flight > UINT16_MAX, "in flight held to 64 KiB (" + to_string( max_in_flight ) + ")" );
+    }
+
+    {
+      // The SYN-ACK echoes the option only if the SYN offered it
+      TCPPeer client { config( true ) };
+      TCPPeer server { config( true ) };
+      check( connect( client, server ).sender_message.window_scale.has_value(), "SYN-ACK didn't echo the option" );
+      TCPPeer plain_client { config( false ) };
+      TCPPeer scaling_server { config( true ) };
+      check( not connect( plain_client, scaling_server ).sender_message.window_scale.has_value(),
+             "SYN-ACK carried the option, but the SYN didn't offer it" );
+    }
+
+    {
+      // Only one side offers it: windows aren't scaled either way
+      TCPPeer client { config( true ) };
+      TCPPeer server { config( false ) };
+      const uint64_t max_in_flight = transfer( client, server, 900'000 );
+      check( max_in_flight <= UINT16_MAX, "window scaled without agreement" );
+    }
+
+    {
+      TCPPeer client { config( false ) };
+      TCPPeer server { config( true ) };
+      const uint64_t max_in_flight = transfer( client, server, 900'000 );
+      check( max_in_flight <= UINT16_MAX, "window scaled without agreement" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
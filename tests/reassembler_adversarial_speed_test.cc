@@ -0,0 +1,102 @@
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// A peer fills each window with one-byte segments at every other index (far end first, so each lands in
+// front of everything already held), then sends the whole window in one segment. The Reassembler's cap on
+// pending pieces is raised to hold them all, so that no insert is cut short by eviction. Returns nanoseconds
+// per segment inserted.
+double adversarial_test( const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t total_bytes, // NOLINT(bugprone-easily-swappable-parameters)
+                         const Reassembler::Placement placement )
+{
+  const string window_data = [&] {
+    string ret;
+    for ( size_t i = 0; i < capacity; ++i ) {
+      ret += static_cast<char>( 'a' + i % 26 );
+    }
+    return ret;
+  }();
+
+  ByteStream stream { capacity };
+  Reassembler reassembler { placement, capacity };
+  size_t segments = 0;
+  size_t bytes_read = 0;
+
+  const auto start_time = steady_clock::now();
+  for ( uint64_t base = 0; base < total_bytes; base += capacity ) {
+    for ( size_t i = 0; i < capacity / 2; ++i ) {
+      const size_t offset = capacity - 1 - 2 * i;
+      reassembler.insert( base + offset, window_data.substr( offset, 1 ), false, stream.writer() );
+      ++segments;
+    }
+    reassembler.insert( base, window_data, base + capacity >= total_bytes, stream.writer() );
+    ++segments;
+
+    while ( stream.reader().bytes_buffered() ) {
+      const auto len = stream.reader().peek().size();
+      bytes_read += len;
+      stream.reader().pop( len );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not stream.reader().is_finished() or bytes_read < total_bytes ) {
+    throw runtime_error( "Reassembler did not deliver the whole stream" );
+  }
+  if ( reassembler.pending_intervals() != 0 ) {
+    throw runtime_error( "Reassembler still holds pieces after the stream finished" );
+  }
+
+  const auto test_duration = duration_cast<duration<double, nano>>( stop_time - start_time );
+  return test_duration.count() / static_cast<double>( segments );
+}
+
+void program_body()
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+    const string name = placement == Reassembler::Placement::Direct ? "direct" : "buffered";
+    vector<double> costs;
+    for ( const size_t capacity : { size_t { 1 } << 10, size_t { 1 } << 14, size_t { 1 } << 18 } ) {
+      const double ns_per_segment = adversarial_test( capacity, size_t { 1 } << 22, placement );
+      costs.push_back( ns_per_segment );
+
+      cout << "Reassembler (" << name << ") with capacity=" << capacity << " under tiny segments took " << fixed
+           << setprecision( 1 ) << ns_per_segment << " ns/segment.\n";
+      debug_output << "      Reassembler (" << name << ", capacity=" << setw( 6 ) << capacity
+                   << ") adversarial: " << fixed << setprecision( 1 ) << ns_per_segment << " ns/segment\n";
+    }
+
+    // The window, and with it the number of pending pieces each segment lands in front of, grows 256x. An
+    // insert that walked the pending pieces would slow down as much, and a search of them by about
+    // log2( 2^17 ) / log2( 2^9 ), so allow up to twice the latter.
+    if ( costs.back() > 2 * ( 17.0 / 9.0 ) * costs.front() ) {
+      throw runtime_error( "Reassembler per-segment cost grew with the number of pending segments." );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
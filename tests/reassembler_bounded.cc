@@ -0,0 +1,96 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t cap = Reassembler::MAX_PENDING_INTERVALS_DFLT;
+
+int main()
+{
+  try {
+    for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+      {
+        ReassemblerTestHarness test { "tiny disjoint segments stop at the cap", 65000, placement };
+
+        // Every other byte, far end first, so that each new piece lands in front of the stored ones
+        for ( uint64_t i = 0; i < cap + 100; ++i ) {
+          const uint64_t index = 2 * ( cap + 100 - i ) - 1;
+          test.execute( Insert { string( 1, static_cast<char>( 'a' + index % 26 ) ), index } );
+        }
+        test.execute( PendingIntervals( cap ) );
+        test.execute( BytesPending( cap ) );
+        test.execute( BytesPushed( 0 ) );
+
+        // The kept pieces are the ones nearest the front of the window
+        string front;
+        for ( uint64_t index = 0; index < 2 * cap; ++index ) {
+          front += static_cast<char>( 'a' + index % 26 );
+        }
+        test.execute( Insert { front, 0 } );
+        test.execute( BytesPushed( 2 * cap ) );
+        test.execute( BytesPending( 0 ) );
+        test.execute( PendingIntervals( 0 ) );
+        test.execute( ReadAll( front ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "evicted bytes can be resent", 65000, placement };
+
+        for ( uint64_t i = 0; i <= cap; ++i ) {
+          test.execute( Insert { "x", 2 * i + 1 } );
+        }
+        test.execute( PendingIntervals( cap ) );
+        test.execute( BytesPending( cap ) );
+
+        test.execute( Insert { string( 2 * cap + 2, 'x' ), 0 }.is_last() );
+        test.execute( BytesPushed( 2 * cap + 2 ) );
+        test.execute( BytesPending( 0 ) );
+        test.execute( IsFinished { false } );
+        test.execute( ReadAll( string( 2 * cap + 2, 'x' ) ) );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        ReassemblerTestHarness test { "contiguous segments past one hole form one range", 65000, placement };
+
+        // More segments than the cap, but with no gaps between them, so none is dropped
+        string data;
+        for ( uint64_t i = 0; i < cap + 100; ++i ) {
+          const string segment( 10, static_cast<char>( 'a' + i % 26 ) );
+          test.execute( Insert { segment, 1 + 10 * i } );
+          data += segment;
+        }
+        test.execute( PendingIntervals( 1 ) );
+        test.execute( BytesPending( data.size() ) );
+
+        test.execute( Insert { "x", 0 } );
+        test.execute( BytesPushed( 1 + data.size() ) );
+        test.execute( PendingIntervals( 0 ) );
+        test.execute( ReadAll( "x" + data ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "adjacent pieces", 65000, placement };
+
+        test.execute( Insert { "b", 1 } );
+        test.execute( Insert { "c", 2 } );
+        test.execute( Insert { "e", 4 } );
+        test.execute( BytesPending( 3 ) );
+        test.execute( Insert { "d", 3 } );
+        test.execute( BytesPending( 4 ) );
+        test.execute( Insert { "a", 0 } );
+        test.execute( BytesPending( 0 ) );
+        test.execute( PendingIntervals( 0 ) );
+        test.execute( ReadAll( "abcde" ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static constexpr auto Direct = Reassembler::Placement::Direct;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "direct in order", 65000, Direct };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( BytesPushed( 8 ) );
+      test.execute( ReadAll( "abcdefgh" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct holes", 65000, Direct };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( BytesPushed( 0 ) );
+      test.execute( BytesPending( 2 ) );
+      test.execute( ReadAll( "" ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 1 ) );
+      test.execute( ReadAll( "ab" ) );
+
+      test.execute( Insert { "c", 2 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "cd" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct overlapping", 65000, Direct };
+
+      test.execute( Insert { "cdef", 2 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( BytesPending( 6 ) );
+      test.execute( Insert { "jk", 9 } );
+      test.execute( BytesPending( 8 ) );
+      test.execute( Insert { "hij", 7 } );
+      test.execute( BytesPending( 9 ) );
+      test.execute( BytesPushed( 0 ) );
+
+      test.execute( Insert { "abc", 0 } );
+      test.execute( BytesPushed( 11 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghijk" ) );
+
+      test.execute( Insert { "abcdefghijk", 0 } );
+      test.execute( BytesPushed( 11 ) );
+      test.execute( BytesPending( 0 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct window", 8, Direct };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( Insert { "efghijkl", 4 } );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 4 ) );
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPushed( 8 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefgh" ) );
+
+      test.execute( Insert { "efghijkl", 4 } );
+      test.execute( BytesPushed( 12 ) );
+      test.execute( ReadAll( "ijkl" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct wraps the ring", 8, Direct };
+
+      test.execute( Insert { "abcdef", 0 } );
+      test.execute( Pop { 4 } );
+      test.execute( Insert { "ijkl", 8 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( ReadAll( "ef" ) );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( BytesPushed( 12 ) );
+      test.execute( ReadAll( "ghijkl" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct last substring", 65000, Direct };
+
+      test.execute( Insert { "c", 2 }.is_last() );
+      test.execute( Insert { "b", 1 } );
+      test.execute( IsFinished { false } );
+      test.execute( BytesPending( 2 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 3 ) );
+      test.execute( ReadAll( "abc" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "direct large gap", 65000, Direct };
+
+      test.execute( Insert { string( 10000, 'y' ), 20000 } );
+      test.execute( BytesPending( 10000 ) );
+      test.execute( Insert { string( 20000, 'x' ), 0 } );
+      test.execute( BytesPushed( 30000 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( string( 20000, 'x' ) + string( 10000, 'y' ) ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
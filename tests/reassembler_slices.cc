@@ -0,0 +1,81 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static constexpr auto Buffered = Reassembler::Placement::Buffered;
+static constexpr auto Direct = Reassembler::Placement::Direct;
+
+int main()
+{
+  try {
+    const Buffer segment { "abcdefghijkl" };
+
+    for ( const auto storage : { ByteStream::Storage::Flat, ByteStream::Storage::Rope } ) {
+      {
+        ReassemblerTestHarness test { "slices out of order", 65000, Buffered, storage };
+
+        test.execute( InsertBuffer { segment.slice( 8 ), 8 } );
+        test.execute( InsertBuffer { segment.slice( 4, 4 ), 4 } );
+        test.execute( BytesPushed( 0 ) );
+        test.execute( BytesPending( 8 ) );
+
+        test.execute( InsertBuffer { segment.slice( 0, 4 ), 0 } );
+        test.execute( BytesPushed( 12 ) );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( "abcdefghijkl" ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "slices overlapping stored ones", 65000, Buffered, storage };
+
+        test.execute( InsertBuffer { segment.slice( 3, 2 ), 3 } );
+        test.execute( InsertBuffer { segment.slice( 7, 2 ), 7 } );
+        test.execute( BytesPending( 4 ) );
+
+        test.execute( InsertBuffer { segment.slice( 2, 9 ), 2 } );
+        test.execute( BytesPending( 9 ) );
+        test.execute( InsertBuffer { segment.slice( 1, 10 ), 1 } );
+        test.execute( BytesPending( 10 ) );
+        test.execute( BytesPushed( 0 ) );
+
+        test.execute( InsertBuffer { segment, 0 } );
+        test.execute( BytesPushed( 12 ) );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( "abcdefghijkl" ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "slices trimmed to the window", 6, Buffered, storage };
+
+        test.execute( InsertBuffer { segment.slice( 2 ), 2 } );
+        test.execute( BytesPending( 4 ) );
+        test.execute( InsertBuffer { segment.slice( 0, 3 ), 0 } );
+        test.execute( BytesPushed( 6 ) );
+        test.execute( ReadAll( "abcdef" ) );
+
+        test.execute( InsertBuffer { segment, 0 } );
+        test.execute( BytesPushed( 12 ) );
+        test.execute( ReadAll( "ghijkl" ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "slices with direct placement", 65000, Direct, storage };
+
+        test.execute( InsertBuffer { segment.slice( 6 ), 6 } );
+        test.execute( BytesPending( 6 ) );
+        test.execute( InsertBuffer { segment.slice( 0, 7 ), 0 } );
+        test.execute( BytesPushed( 12 ) );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( "abcdefghijkl" ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
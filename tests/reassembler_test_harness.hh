@@ -28,10 +28,15 @@ struct ReassemblerByteStreamTestStep : public TestStep<StreamAndReassembler>
 class ReassemblerTestHarness : public TestHarness<StreamAndReassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Placement placement = Reassembler::Placement::Buffered,
+                          ByteStream::Storage storage = ByteStream::Storage::Flat )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { ByteStream { capacity }, Reassembler {} } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( placement == Reassembler::Placement::Direct ? ", direct placement" : "" )
+                     + ByteStreamTestHarness::storage_description( storage ),
+                   { ByteStream { capacity, storage }, Reassembler { placement } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -50,6 +55,13 @@ struct BytesPending : public ExpectNumber<StreamAndReassembler, uint64_t>
   uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_pending(); }
 };
 
+struct PendingIntervals : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pending_intervals"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.pending_intervals(); }
+};
+
 struct Insert : public Action<StreamAndReassembler>
 {
   std::string data_;
@@ -79,3 +91,24 @@ struct Insert : public Action<StreamAndReassembler>
     sr.second.insert( first_index_, data_, is_last_substring_, sr.first.writer() );
   }
 };
+
+struct InsertBuffer : public Action<StreamAndReassembler>
+{
+  Buffer data_;
+  uint64_t first_index_;
+
+  InsertBuffer( Buffer data, uint64_t first_index ) : data_( std::move( data ) ), first_index_( first_index ) {}
+
+  std::string description() const override
+  {
+    std::ostringstream ss;
+    ss << "insert Buffer \"" << Printer::prettify( std::string { std::string_view { data_ } } ) << "\" @ index "
+       << first_index_;
+    return ss.str();
+  }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    sr.second.insert( first_index_, data_, false, sr.first.writer() );
+  }
+};
@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using ReceiverSet = std::pair<StreamAndReassembler, TCPReceiver>;
 
@@ -28,10 +29,13 @@ struct ReceiverSetTestStep : public TestStep<ReceiverSet>
 class TCPReceiverTestHarness : public TestHarness<ReceiverSet>
 {
 public:
-  TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
+  TCPReceiverTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Placement placement = Reassembler::Placement::Buffered )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { { ByteStream { capacity }, Reassembler {} }, TCPReceiver {} } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( placement == Reassembler::Placement::Direct ? ", direct placement" : "" ),
+                   { { ByteStream { capacity }, Reassembler { placement } }, TCPReceiver {} } )
   {}
 
   template<std::derived_from<TestStep<StreamAndReassembler>> T>
@@ -49,11 +53,11 @@ public:
   using TestHarness<ReceiverSet>::execute;
 };
 
-struct ExpectWindow : public ExpectNumber<ReceiverSet, uint16_t>
+struct ExpectWindow : public ExpectNumber<ReceiverSet, uint32_t>
 {
   using ExpectNumber::ExpectNumber;
   std::string name() const override { return "window_size"; }
-  uint16_t value( ReceiverSet& rs ) const override { return rs.second.send( rs.first.first.writer() ).window_size; }
+  uint32_t value( ReceiverSet& rs ) const override { return rs.second.send( rs.first.first.writer() ).window_size; }
 };
 
 struct ExpectAckno : public ExpectNumber<ReceiverSet, std::optional<Wrap32>>
@@ -94,6 +98,42 @@ struct ExpectAcknoBetween : public Expectation<ReceiverSet>
   }
 };
 
+struct ExpectSACK : public Expectation<ReceiverSet>
+{
+  std::vector<SACKBlock> blocks_;
+  explicit ExpectSACK( std::vector<SACKBlock> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string describe( const std::vector<SACKBlock>& blocks )
+  {
+    std::string result = "{";
+    for ( const auto& block : blocks ) {
+      result += " [" + to_string( block.left ) + ", " + to_string( block.right ) + ")";
+    }
+    return result + " }";
+  }
+
+  std::string description() const override { return "SACK blocks = " + describe( blocks_ ); }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    const auto sack = rs.second.send( rs.first.first.writer(), rs.first.second ).sack;
+    if ( sack != blocks_ ) {
+      throw ExpectationViolation( "The TCPReceiver should have sent SACK blocks " + describe( blocks_ )
+                                  + ", but instead sent " + describe( sack ) + "." );
+    }
+  }
+};
+
+struct ExpectTimestampEcho : public ExpectNumber<ReceiverSet, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "timestamp_echo"; }
+  std::optional<uint32_t> value( ReceiverSet& rs ) const override
+  {
+    return rs.second.send( rs.first.first.writer() ).timestamp_echo;
+  }
+};
+
 struct HasAckno : public ExpectBool<ReceiverSet>
 {
   using ExpectBool::ExpectBool;
@@ -104,6 +144,15 @@ struct HasAckno : public ExpectBool<ReceiverSet>
   }
 };
 
+struct WindowShift : public Action<ReceiverSet>
+{
+  uint8_t shift_;
+
+  explicit WindowShift( uint8_t shift ) : shift_( shift ) {}
+  std::string description() const override { return "window scale set to " + std::to_string( shift_ ); }
+  void execute( ReceiverSet& rs ) const override { rs.second.set_window_shift( shift_ ); }
+};
+
 struct SegmentArrives : public Action<ReceiverSet>
 {
   TCPSenderMessage msg_ {};
@@ -121,6 +170,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_sack_permitted()
+  {
+    msg_.SACK_permitted = true;
+    return *this;
+  }
+
   SegmentArrives& with_seqno( Wrap32 seqno_ )
   {
     msg_.seqno = seqno_;
@@ -135,6 +190,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_timestamp( uint32_t timestamp )
+  {
+    msg_.timestamp = timestamp;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -155,6 +216,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     if ( msg_.SYN ) {
       ss << " +SYN";
     }
+    if ( msg_.SACK_permitted ) {
+      ss << " +SACK-permitted";
+    }
+    if ( msg_.timestamp.has_value() ) {
+      ss << " TSval=" << msg_.timestamp.value();
+    }
     if ( not msg_.payload.empty() ) {
       ss << " payload=\"" << Printer::prettify( msg_.payload ) << "\"";
     }
@@ -0,0 +1,73 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    for ( const auto placement : { Reassembler::Placement::Buffered, Reassembler::Placement::Direct } ) {
+      {
+        const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+        TCPReceiverTestHarness test { "SACK blocks report out-of-order data, latest first", 4000, placement };
+        test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+        test.execute( ExpectSACK { {} } );
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+        test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } } } } );
+        test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "gh" ) );
+        test.execute( ExpectSACK {
+          { { Wrap32 { isn + 7 }, Wrap32 { isn + 9 } }, { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } } } } );
+
+        // Filling the gap between them merges the two blocks
+        test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ) );
+        test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } } } } );
+
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+        test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+        test.execute( ExpectSACK { {} } );
+      }
+
+      {
+        const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+        TCPReceiverTestHarness test { "At most four SACK blocks", 4000, placement };
+        test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+        for ( uint32_t offset = 3; offset <= 19; offset += 4 ) {
+          test.execute( SegmentArrives {}.with_seqno( isn + offset ).with_data( "xy" ) );
+        }
+        test.execute( ExpectSACK { { { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                     { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } },
+                                     { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } },
+                                     { Wrap32 { isn + 7 }, Wrap32 { isn + 9 } } } } );
+
+        // A repeat of the oldest makes it the most recent again
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "xy" ) );
+        test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } },
+                                     { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                     { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } },
+                                     { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } } } } );
+      }
+
+      {
+        const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+        TCPReceiverTestHarness test { "No SACK blocks unless the sender permitted them", 4000, placement };
+        test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+        test.execute( BytesPending { 2 } );
+        test.execute( ExpectSACK { {} } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
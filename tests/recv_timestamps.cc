@@ -0,0 +1,72 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "The latest timestamp to arrive in order is echoed", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 100 ) );
+      test.execute( ExpectTimestampEcho { 100 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ).with_timestamp( 105 ) );
+      test.execute( ExpectTimestampEcho { 105 } );
+
+      // A segment beyond a gap isn't echoed, but the one that fills the gap is
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ).with_timestamp( 110 ) );
+      test.execute( ExpectTimestampEcho { 105 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ).with_timestamp( 111 ) );
+      test.execute( ExpectTimestampEcho { 111 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS drops an old duplicate from an earlier wrap", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 1000 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 1010 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+
+      // Its sequence numbers look like just what the receiver wants next, but its timestamp gives it away
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "XYZ" ).with_timestamp( 500 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTimestampEcho { 1010 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( 1020 ) );
+      test.execute( ReadAll { "abcdef" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Timestamps wrap around too", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( UINT32_MAX - 5 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 4 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTimestampEcho { 4 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Without timestamps, nothing is echoed", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) );
+      test.execute( ExpectTimestampEcho { nullopt } );
+      test.execute( ReadAll { "abc" } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
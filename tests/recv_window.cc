@@ -105,6 +105,33 @@ int main()
       test.execute( BytesPending( 0 ) );
     }
 
+    {
+      TCPReceiverTestHarness test { "window scaling lets a large window be advertised", 10'000'000 };
+      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( WindowShift { 8 } );
+      test.execute( ExpectWindow { 9'999'872 } ); // Rounded down to a multiple of 256
+      test.execute( WindowShift { 7 } );
+      test.execute( ExpectWindow { UINT16_MAX << 7 } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "window scaling stops at 1 GiB", 4'000'000'000 };
+      test.execute( WindowShift { 20 } );
+      test.execute( ExpectWindow { TCPReceiverMessage::MAX_WINDOW } );
+    }
+
+    {
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "a scaled window shrinks as data arrives", 100'000 };
+      test.execute( WindowShift { 4 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { 100'000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) );
+      test.execute( ExpectWindow { 99'984 } ); // 3 bytes fewer, rounded down to a multiple of 16
+      test.execute( ReadAll { "abc" } );
+      test.execute( ExpectWindow { 100'000 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,80 @@
+#include "send_buffer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+void check( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "SendBuffer: " + what );
+  }
+}
+
+bool throws( const SendBuffer& buffer, uint64_t index, uint64_t len )
+{
+  try {
+    buffer.range( index, len );
+  } catch ( const runtime_error& ) {
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      SendBuffer buffer;
+      const Buffer first { string { "abcd" } };
+      const Buffer second { string { "efgh" } };
+      buffer.append( 0, first );
+      buffer.append( 4, second );
+      buffer.append( 8, Buffer {} );
+      buffer.append( 8, Buffer { string { "ij" } } );
+      check( buffer.bytes_held() == 10, "wrong number of bytes held" );
+
+      // Within one piece, the range shares it; across pieces, it's a copy
+      const Buffer shared = buffer.range( 5, 2 );
+      check( string_view { shared } == "fg", "wrong bytes within a piece" );
+      check( string_view { shared }.data() == string_view { second }.data() + 1, "range within a piece copied" );
+      const Buffer spanning = buffer.range( 2, 7 );
+      check( string_view { spanning } == "cdefghi", "wrong bytes across pieces" );
+      check( string_view { spanning }.data() != string_view { first }.data() + 2, "range across pieces shared" );
+      check( buffer.range( 0, 10 ).size() == 10 and buffer.range( 3, 0 ).empty(), "wrong range size" );
+
+      check( throws( buffer, 8, 3 ), "range past the end given" );
+      bool threw = false;
+      try {
+        buffer.append( 11, Buffer { string { "x" } } );
+      } catch ( const runtime_error& ) {
+        threw = true;
+      }
+      check( threw, "append with a gap accepted" );
+
+      // Only pieces wholly before the index go
+      buffer.release_before( 6 );
+      check( buffer.bytes_held() == 6, "released a piece still partly needed" );
+      check( string_view { buffer.range( 6, 4 ) } == "ghij", "wrong bytes after a release" );
+      check( throws( buffer, 3, 2 ), "released bytes given" );
+      buffer.release_before( 10 );
+      check( buffer.bytes_held() == 0, "bytes held after releasing everything" );
+      buffer.append( 10, Buffer { string { "kl" } } );
+      check( string_view { buffer.range( 11, 1 ) } == "l", "wrong bytes after starting over" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
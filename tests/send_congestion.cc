@@ -0,0 +1,139 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t WIN = 40000; // Large enough that only congestion control limits the sender
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    for ( const auto algorithm : { CongestionControl::NewReno, CongestionControl::Cubic } ) {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      const uint64_t ssthresh_after_timeout = algorithm == CongestionControl::Cubic ? 7700 : 5500;
+
+      TCPSenderTestHarness test { "Slow start, then a timeout", cfg, algorithm };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectCongestionWindow { 10 * MSS } );
+      test.execute( ExpectSlowStartThreshold { numeric_limits<uint64_t>::max() } );
+
+      // The initial window is ten segments, however much the receiver offers
+      test.execute( Push { string( 60000, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 10 * MSS } );
+
+      // Each ack in slow start opens the window by (at most) one segment
+      test.execute( AckReceived { isn + 1 + MSS }.with_win( WIN ) );
+      test.execute( ExpectCongestionWindow { 11 * MSS } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 10 * MSS ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 11 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+
+      // A timeout collapses the window to one segment
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + MSS ) );
+      test.execute( ExpectCongestionWindow { MSS } );
+      test.execute( ExpectSlowStartThreshold { ssthresh_after_timeout } );
+
+      // A further timeout doesn't lower the threshold again
+      test.execute( Tick { 2 * TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + MSS ) );
+      test.execute( ExpectCongestionWindow { MSS } );
+      test.execute( ExpectSlowStartThreshold { ssthresh_after_timeout } );
+
+      test.execute( AckReceived { isn + 1 + 12 * MSS }.with_win( WIN ) );
+      test.execute( ExpectCongestionWindow { 2 * MSS } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 12 * MSS ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 13 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "NewReno congestion avoidance", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 60000, 'x' ) } );
+      test.execute( AckReceived { isn + 1 + MSS }.with_win( WIN ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectCongestionWindow { MSS } );
+      test.execute( ExpectSlowStartThreshold { 5500 } );
+
+      // Slow start back up past the threshold...
+      uint32_t acked = 12;
+      for ( const uint64_t cwnd : { 2, 3, 4, 5, 6 } ) {
+        test.execute( AckReceived { isn + 1 + acked++ * MSS }.with_win( WIN ) );
+        test.execute( ExpectCongestionWindow { cwnd * MSS } );
+        test.execute( ExpectSeqnosInFlight { cwnd * MSS } );
+      }
+
+      // ... then one segment per window's worth of acks
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        test.execute( AckReceived { isn + 1 + acked++ * MSS }.with_win( WIN ) );
+        test.execute( ExpectCongestionWindow { 6 * MSS } );
+      }
+      test.execute( AckReceived { isn + 1 + acked++ * MSS }.with_win( WIN ) );
+      test.execute( ExpectCongestionWindow { 7 * MSS } );
+      test.execute( ExpectSeqnosInFlight { 7 * MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "An application-limited window doesn't grow", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      for ( uint32_t i = 0; i < 20; ++i ) {
+        test.execute( Push { string( 100, 'x' ) } );
+        test.execute( ExpectMessage {}.with_payload_size( 100 ) );
+        test.execute( AckReceived { isn + 1 + ( i + 1 ) * 100 }.with_win( WIN ) );
+      }
+      test.execute( ExpectCongestionWindow { 10 * MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "The receiver's window still applies", cfg, CongestionControl::Cubic };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1500 ) );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
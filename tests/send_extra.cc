@@ -36,7 +36,8 @@ int main()
       test.execute( Push( "def" ) );
       test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "def" ) );
       test.execute( Tick { 6 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      // The retransmission starts at the ackno and takes in what follows, up to an MSS
+      test.execute( ExpectMessage {}.with_payload_size( 6 ).with_data( "abcdef" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
     }
 
@@ -60,7 +61,7 @@ int main()
       test.execute( Push( "def" ) );
       test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "def" ) );
       test.execute( Tick { 200 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 6 ).with_data( "abcdef" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
     }
 
@@ -109,12 +110,12 @@ int main()
       test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "def" ).with_seqno( isn + 4 ) );
       test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
       test.execute( Tick { 6 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 6 ).with_data( "abcdef" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { rto * 2 - 5 } );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { 8 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 6 ).with_data( "abcdef" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
     }
 
@@ -140,12 +141,12 @@ int main()
       test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "ghi" ).with_seqno( isn + 7 ) );
       test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
       test.execute( Tick { 6 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 9 ).with_data( "abcdefghi" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { rto * 2 - 5 } );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { 5 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 9 ).with_data( "abcdefghi" ).with_seqno( isn + 1 ) );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { rto * 4 - 5 } );
       test.execute( ExpectNoSegment {} );
@@ -153,7 +154,7 @@ int main()
       test.execute( Tick { rto - 1 } );
       test.execute( ExpectNoSegment {} );
       test.execute( Tick { 2 } );
-      test.execute( ExpectMessage {}.with_payload_size( 3 ).with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 6 ).with_data( "defghi" ).with_seqno( isn + 4 ) );
       test.execute( ExpectNoSegment {} );
     }
     {
@@ -477,8 +478,7 @@ int main()
       test.execute( AckReceived { Wrap32 { isn + 12 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
       test.execute( Tick { 5 * rto } );
-      test.execute(
-        ExpectMessage {}.with_payload_size( 4 ).with_data( "ijkl" ).with_seqno( isn + 8 ).with_fin( true ) );
+      test.execute( ExpectMessage {}.with_payload_size( 0 ).with_seqno( isn + 12 ).with_fin( true ) );
       test.execute( ExpectNoSegment {} );
       test.execute( AckReceived( Wrap32 { isn + 13 } ).with_win( 1000 ) );
       test.execute( AckReceived( Wrap32 { isn + 1 } ).with_win( 1000 ) );
@@ -529,6 +529,26 @@ int main()
       test.execute( ExpectSeqnosInFlight { 0 } );
       test.execute( ExpectSeqno { isn + 2 + bigstring.size() } );
     }
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.send_storage = ByteStream::Storage::Rope;
+
+      TCPSenderTestHarness test { "Segments from a Rope stream span and split pushed Buffers", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 2 ) );
+      test.execute( Push( "abc" ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "ab" ).with_seqno( isn + 1 ) );
+      test.execute( Push( "de" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 3 } }.with_win( 10 ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "cde" ).with_seqno( isn + 3 ) );
+      test.execute( Push( "fghij" ).with_close() );
+      test.execute( ExpectMessage {}.with_data( "fghij" ).with_fin( true ).with_seqno( isn + 6 ) );
+      test.execute( ExpectNoSegment {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,113 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "The SYN advertises the default MSS", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_mss( TCPConfig::MAX_PAYLOAD_SIZE ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = TCPConfig::mss_for_mtu( 9000 );
+
+      TCPSenderTestHarness test { "Jumbo frames: segments as large as the MSS allows", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_mss( 8920 ) );
+      test.execute( PeerMSS { 9000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 30000 ) );
+      test.execute( Push { string( 20000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 8920 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 8920 ).with_seqno( isn + 1 + 8920 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2160 ).with_seqno( isn + 1 + 2 * 8920 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 8960;
+
+      TCPSenderTestHarness test { "Segments are held to the peer's MSS", cfg };
+      test.execute( PeerMSS { 1460 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_mss( 8960 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 80 ).with_seqno( isn + 2921 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 2000;
+
+      TCPSenderTestHarness test { "A smaller MSS cuts up outstanding segments for retransmission", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 1000, 'a' ) + string( 1000, 'b' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 2000 ).with_seqno( isn + 1 ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( string( 1000, 'a' ) ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 5000 ) );
+      test.execute( ExpectSeqnosInFlight { 1000 } );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( string( 1000, 'b' ) ).with_seqno( isn + 1001 ) );
+      test.execute( AckReceived { isn + 2001 }.with_win( 5000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      // Without an MSS option on the peer's SYN, segments are held to 536 bytes
+      TCPConfig cfg;
+      cfg.mss = 1460;
+      TCPPeer peer { cfg };
+      TCPSegment syn;
+      syn.sender_message.SYN = true;
+      syn.receiver_message.window_size = 5000;
+      peer.receive( syn );
+      if ( peer.sender().mss() != TCPConfig::DEFAULT_PEER_MSS ) {
+        throw runtime_error( "MSS without the peer's option was " + to_string( peer.sender().mss() ) );
+      }
+    }
+
+    // An MTU too small for the largest headers still leaves a one-byte MSS, rather than wrapping around
+    static_assert( TCPConfig::mss_for_mtu( 68 ) == 1 );
+    static_assert( TCPConfig::mss_for_mtu( FdAdapterConfig::MIN_MTU ) == 1 );
+    static_assert( TCPConfig::mss_for_mtu( 1500 ) == 1420 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "By default, small writes go right away", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 50, 'a' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 50, 'a' ) ).with_seqno( isn + 1 ) );
+      test.execute( Push { string( 50, 'b' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 50, 'b' ) ).with_seqno( isn + 51 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.nodelay = false;
+
+      TCPSenderTestHarness test { "Nagle: small writes coalesce while data is in flight", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 50, 'a' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 50, 'a' ) ).with_seqno( isn + 1 ) );
+      for ( int i = 0; i < 19; ++i ) {
+        test.execute( Push { string( 50, 'b' ) } );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( AckReceived { isn + 51 }.with_win( 5000 ) );
+      test.execute( ExpectMessage {}.with_data( string( 950, 'b' ) ).with_seqno( isn + 51 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.nodelay = false;
+
+      TCPSenderTestHarness test { "Nagle: full segments and the end of the stream still go", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 10, 'a' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 10 ).with_seqno( isn + 1 ) );
+      test.execute( Push { string( 2500, 'b' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 11 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1011 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 2011 ).with_fin( true ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Corked, only full segments go until uncorked", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( SetCork { true } );
+      test.execute( Push { string( 50, 'a' ) } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { string( 1000, 'b' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 50, 'a' ) + string( 950, 'b' ) ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( SetCork { false } );
+      test.execute( ExpectMessage {}.with_data( string( 50, 'b' ) ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Closing the stream sends what the cork held", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( SetCork { true } );
+      test.execute( Push { "hello" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_data( "hello" ).with_seqno( isn + 1 ).with_fin( true ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
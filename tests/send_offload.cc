@@ -0,0 +1,81 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.segmentation_offload = true;
+
+      TCPSenderTestHarness test { "With offload, one message fills the window", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 6000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 5000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.segmentation_offload = true;
+
+      TCPSenderTestHarness test { "One burst can fill a large window", cfg, CongestionControl::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      test.execute( Push { string( 60000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 60000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.segmentation_offload = true;
+
+      TCPSenderTestHarness test { "A burst is retransmitted an MSS at a time", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5000 ) );
+      test.execute( Push { string( 1000, 'a' ) + string( 1000, 'b' ) + string( 1500, 'c' ) }.with_close() );
+      test.execute( ExpectMessage {}.with_payload_size( 3500 ).with_seqno( isn + 1 ).with_fin( true ) );
+      test.execute( ExpectSeqnosInFlight { 3501 } );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( string( 1000, 'a' ) ).with_seqno( isn + 1 ).with_fin( false ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 5000 ) );
+      test.execute( ExpectSeqnosInFlight { 2501 } );
+      test.execute( AckReceived { isn + 2001 }.with_win( 5000 ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( string( 1000, 'c' ) ).with_seqno( isn + 2001 ).with_fin( false ) );
+      test.execute( AckReceived { isn + 3001 }.with_win( 5000 ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( string( 500, 'c' ) ).with_seqno( isn + 3001 ).with_fin( true ) );
+      test.execute( AckReceived { isn + 3502 }.with_win( 5000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
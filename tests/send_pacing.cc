@@ -0,0 +1,61 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "BBR sends the initial window at once", cfg, CongestionControl::Bbr };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 40000 ) );
+      test.execute( Push { string( 20000, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // Held back by the window, not the pacer
+      test.execute( ExpectNextSendTime { nullopt } );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.fixed_isn = Wrap32( rd() );
+
+      TCPSenderTestHarness test { "BBR fills a bottleneck without queueing", cfg, CongestionControl::Bbr };
+      test.execute( ExpectBottleneckUse { 4000, 200, 10, 0.9, 10 } );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.fixed_isn = Wrap32( rd() );
+
+      TCPSenderTestHarness test { "BBR on a faster, longer path", cfg, CongestionControl::Bbr };
+      test.execute( ExpectBottleneckUse { 4000, 2000, 20, 0.9, 10 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
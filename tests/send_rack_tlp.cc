@@ -0,0 +1,149 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t WIN = 40000; // Large enough that only congestion control limits the sender
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test {
+        "A tail loss probe brings on SACK recovery instead of a timeout", cfg, CongestionControl::NewReno, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectRTO { 200 } );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+
+      // Segments 2 and 3, the tail of the burst, are lost. The probe goes two round trips after the last ack.
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ) );
+      test.execute( Tick { 99 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // Its SACK shows that segment 2, sent well before it, is lost
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 3 ), seg( 4 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 2 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { seg( 4 ) }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rack_tlp = false;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test {
+        "Without RACK-TLP, a lost tail waits for the timeout", cfg, CongestionControl::NewReno, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ) );
+      test.execute( Tick { 199 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 2 ) ) );
+      test.execute( ExpectCongestionWindow { MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test { "RACK: a segment is lost a reordering window after a later one arrives",
+                                  cfg,
+                                  CongestionControl::NewReno,
+                                  true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 48 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 3 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+
+      // Segment 1 arrives, but not segment 0. One SACK isn't enough for fast retransmit, but once segment 0
+      // has had a round trip and a quarter of the minimum round trip (12 ms), it's deemed lost.
+      test.execute( Tick { 48 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ).with_sack( seg( 1 ), seg( 2 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 11 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 3 ) }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test {
+        "A lone segment is probed when it would have timed out", cfg, CongestionControl::NewReno, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( MSS, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+
+      // The probe takes the timeout's place, so the congestion window is halved rather than collapsing
+      test.execute( Tick { 199 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { seg( 1 ) }.with_win( WIN ) );
+      test.execute( ExpectCongestionWindow { 2 * MSS } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
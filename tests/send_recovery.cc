@@ -0,0 +1,153 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t WIN = 40000; // Large enough that only congestion control limits the sender
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test {
+        "Three duplicate acks: fast retransmit and recovery", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 12 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // Limited transmit: each of the first two duplicates lets one new segment out
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 10 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 11 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 10 * MSS } );
+
+      // The third retransmits the first segment straight away, and halves the window
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSlowStartThreshold { 6 * MSS } );
+      test.execute( ExpectCongestionWindow { 6 * MSS } );
+
+      // Further duplicates inflate the window, one segment each, until new data fits
+      test.execute( Push { string( MSS, 'y' ) } );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 12 * MSS ).with_data(
+        string( MSS, 'y' ) ) );
+
+      // Once everything sent before recovery is acked, the window deflates to the threshold
+      test.execute( AckReceived { isn + 1 + 12 * MSS }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { MSS } );
+      test.execute( ExpectCongestionWindow { 6 * MSS } );
+      test.execute( Push { string( 10 * MSS, 'z' ) } );
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + ( 13 + i ) * MSS ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "A partial ack retransmits the next hole", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 10 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 1 + 3 * MSS }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 3 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 + 7 * MSS }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + 7 * MSS ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 1 + 10 * MSS }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectCongestionWindow { 5 * MSS } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Duplicates of data sent before a timeout don't start recovery", cfg,
+                                  CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 ) );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { MSS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Window updates aren't duplicate acks", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( isn + 1 + i * MSS ) );
+      }
+      for ( uint16_t i = 1; i <= 3; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( WIN - i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 10 * MSS } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
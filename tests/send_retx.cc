@@ -112,6 +112,57 @@ int main()
       test.execute( Tick { 1 }.with_max_retx_exceeded( true ) );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "A partly acked segment is retx as only its unacked bytes", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abcdefgh" } );
+      test.execute( ExpectMessage {}.with_data( "abcdefgh" ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectSeqnosInFlight { 5 } );
+      test.execute( Tick { retx_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "defgh" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectSeqnosInFlight { 5 } );
+      test.execute( AckReceived { Wrap32 { isn + 9 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+      cfg.mss = 8;
+
+      TCPSenderTestHarness test { "A retransmission after a partial ack is coalesced up to the MSS", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abcdefghijklmnop" } );
+      test.execute( ExpectMessage {}.with_data( "abcdefgh" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "ijklmnop" ).with_seqno( isn + 9 ) );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_data( "defghijk" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 13 } );
+      test.execute( AckReceived { Wrap32 { isn + 12 } } );
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_data( "lmnop" ).with_seqno( isn + 12 ) );
+      test.execute( AckReceived { Wrap32 { isn + 17 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,185 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.min_rto = 1;
+
+      TCPSenderTestHarness test { "SRTT, RTTVAR and RTO follow RFC 6298", cfg, CongestionControl::None, true };
+      test.execute( ExpectSmoothedRTT { nullopt } );
+      test.execute( ExpectRTO { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 } );
+
+      // The first sample sets SRTT = R, RTTVAR = R/2
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTTVariation { 50 } );
+      test.execute( ExpectRTO { 300 } );
+
+      // Later ones are folded in with gains of 1/4 (RTTVAR, against the old SRTT) and 1/8 (SRTT)
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 200 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectRTTVariation { 62.5 } );
+      test.execute( ExpectSmoothedRTT { 112.5 } );
+      test.execute( ExpectRTO { 363 } );
+
+      // The timer runs on the new timeout
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 362 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.min_rto = 1;
+
+      TCPSenderTestHarness test {
+        "Karn's rule: retransmitted segments aren't timed", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTTVariation { 50 } );
+
+      // Without a new sample, the backed-off timeout stays in force
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 599 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { isn + 7 } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+
+      // An ack of a segment sent only once is a fair sample again
+      test.execute( Push { "ghi" } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 10 } );
+      test.execute( ExpectRTTVariation { 52.5 } );
+      test.execute( ExpectSmoothedRTT { 92.5 } );
+      test.execute( ExpectRTO { 303 } );
+      test.execute( Push { "jkl" } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+      test.execute( Tick { 302 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.min_rto = 1;
+      cfg.mss = 3;
+
+      TCPSenderTestHarness test {
+        "Karn's rule: an ack that covers a retransmission isn't timed", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+
+      // The first segment is retransmitted; one ack then covers it and two segments sent only once
+      test.execute( Push { "abcdefghi" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 10 } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTTVariation { 50 } );
+
+      // So the backed-off timeout stays in force
+      test.execute( Push { "jkl" } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+      test.execute( Tick { 599 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test {
+        "A short path's timeout stops at the minimum", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSmoothedRTT { 5 } );
+      test.execute( ExpectRTO { TCPConfig::MIN_RTO_DFLT } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { TCPConfig::MIN_RTO_DFLT - 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.max_rto = 3000;
+
+      TCPSenderTestHarness test { "Backoff stops at the maximum timeout", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      for ( const uint64_t timeout : { 1000, 2000, 3000, 3000 } ) {
+        test.execute( Tick { timeout - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
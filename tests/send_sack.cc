@@ -0,0 +1,168 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t WIN = 40000; // Large enough that only congestion control limits the sender
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test { "SACK recovery retransmits only the holes", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 10 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+
+      // Segments 2 and 5 are lost
+      test.execute( AckReceived { seg( 1 ) }.with_win( WIN ) );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ) );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 3 ), seg( 4 ) ) );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 3 ), seg( 5 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 6 ), seg( 7 ) ).with_sack( seg( 3 ),
+                                                                                                      seg( 5 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 2 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 4 * MSS } );
+
+      // Segment 5 counts as lost once three segments above it have arrived; it goes out before new data,
+      // which waits until the network holds less than the congestion window
+      test.execute( Push { string( 2 * MSS, 'y' ) } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 6 ), seg( 8 ) ).with_sack( seg( 3 ),
+                                                                                                      seg( 5 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 2 ) }.with_win( WIN ).with_sack( seg( 6 ), seg( 9 ) ).with_sack( seg( 3 ),
+                                                                                                      seg( 5 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 5 ) ) );
+      test.execute(
+        ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 10 ) ).with_data( string( MSS, 'y' ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The first retransmission arrives (a partial ack), leaving room for the rest of the new data
+      test.execute( AckReceived { seg( 5 ) }.with_win( WIN ).with_sack( seg( 6 ), seg( 9 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 11 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The second one ends recovery
+      test.execute( AckReceived { seg( 10 ) }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { 2 * MSS } );
+      test.execute( ExpectCongestionWindow { 4 * MSS } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test {
+        "Enough selectively acked data starts recovery early", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 6 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 6; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+
+      // One ack reports segments 1-3 at once (as a stretch ack might)
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 1 ), seg( 4 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.sack = false;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test { "Without SACK, blocks are ignored", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 10 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 1 ), seg( 4 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 1 ), seg( 5 ) ) );
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 1 ), seg( 6 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 7 ), seg( 10 ) ).with_sack( seg( 1 ),
+                                                                                                       seg( 6 ) ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      const auto seg = [&]( uint32_t n ) { return isn + 1 + n * MSS; };
+
+      TCPSenderTestHarness test {
+        "A timeout discards the scoreboard, so reneged data is repaired", cfg, CongestionControl::NewReno, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { isn + 1 }.with_win( WIN ) );
+      test.execute( Push { string( 4 * MSS, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( i ) ) );
+      }
+
+      // Segment 2 arrives out of order, and RACK finds segments 0 and 1 lost
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { seg( 0 ) }.with_win( WIN ).with_sack( seg( 2 ), seg( 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 2 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 1 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The retransmissions are lost too, and the timer expires
+      test.execute( Tick { 188 } );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 0 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The receiver has dropped segment 2 (reneged), so it is missing again when segment 0 arrives. Everything
+      // sent before segment 0's retransmission is now lost, segment 2 included.
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { seg( 1 ) }.with_win( WIN ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 1 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 2 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( MSS ).with_seqno( seg( 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 4 ) }.with_win( WIN ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Timestamps are offered on the SYN, and used once the peer agrees", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_timestamp( 0 ) );
+      test.execute( PeerTimestamps { true } );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 40 ) );
+      test.execute( Tick { 25 } );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_timestamp( 65 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without the peer's agreement, only the SYN carries a timestamp", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_timestamp( 0 ) );
+      test.execute( PeerTimestamps { false } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( nullopt ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.timestamps = false;
+
+      TCPSenderTestHarness test { "Timestamps can be turned off", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_timestamp( nullopt ) );
+      test.execute( PeerTimestamps { true } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( nullopt ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.min_rto = 1;
+
+      TCPSenderTestHarness test {
+        "The echo times a retransmission, which Karn's rule can't", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( PeerTimestamps { true } );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 100 ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 400 ) );
+
+      // The ack echoes the retransmission, so it's timed from there: a 40 ms sample, and the backoff ends
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 4 }.with_timestamp_echo( 400 ) );
+      test.execute( ExpectSmoothedRTT { 92.5 } );
+      test.execute( ExpectRTTVariation { 52.5 } );
+      test.execute( ExpectRTO { 303 } );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 302 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.min_rto = 1;
+
+      TCPSenderTestHarness test {
+        "A duplicate ack's older echo isn't a sample", cfg, CongestionControl::None, true };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( PeerTimestamps { true } );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTTVariation { 50 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -140,6 +140,25 @@ int main()
       test.execute( ExpectMessage {}.with_fin( true ).with_data( "4567" ) );
       test.execute( ExpectNoSegment {} );
     }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.recv_capacity = 1'000'000;
+      cfg.send_capacity = 200'000;
+
+      TCPSenderTestHarness test { "With window scaling, a window beyond 64 KiB fills", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_window_scale( 4 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 150'000 ) );
+      test.execute( Push { string( 200'000, 'x' ) } );
+      for ( uint32_t i = 0; i < 150; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 150'000 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,120 @@
+#include "byte_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// A sender keeps a window full of one-byte segments while the receiver acks them one at a time, a millisecond
+// apart, so every ack leaves the rest of the window outstanding. With `sack`, the receiver has sent a SACK
+// block (a duplicate of the SYN, RFC 2883), so every ack runs RACK loss detection too; that needs congestion
+// control, whose initial window must hold `window` segments. Returns nanoseconds per ack (including sending
+// the segment that replaces the one acked).
+double ack_test( const uint16_t window, const size_t acks, const bool sack )
+{
+  TCPConfig cfg;
+  const Wrap32 isn { 0 };
+  cfg.fixed_isn = isn;
+  if ( not sack ) {
+    cfg.congestion_control = CongestionControl::None; // Only the receiver's window limits the sender
+  }
+
+  ByteStream stream { 1 };
+  TCPSender sender { cfg };
+  size_t segments = 0;
+  const auto drain = [&] {
+    while ( sender.maybe_send().has_value() ) {
+      ++segments;
+    }
+  };
+  const auto send_byte = [&] {
+    stream.writer().push( string { "x" } );
+    sender.push( stream.reader() );
+    drain();
+  };
+
+  sender.push( stream.reader() );
+  drain();
+  sender.tick( 1 );
+  sender.receive( { isn + 1, window, sack ? vector<SACKBlock> { { isn, isn + 1 } } : vector<SACKBlock> {} } );
+  for ( size_t i = 0; i < window; ++i ) {
+    send_byte();
+  }
+  if ( sender.sequence_numbers_in_flight() != window ) {
+    throw runtime_error( "Sender did not fill the window" );
+  }
+
+  uint64_t acked = 1;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < acks; ++i ) {
+    ++acked;
+    sender.tick( 1 );
+    sender.receive( { isn + static_cast<uint32_t>( acked ), window, {} } );
+    send_byte();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( sender.sequence_numbers_in_flight() != window or segments != 1 + window + acks ) {
+    throw runtime_error( "Sender did not keep the window full" );
+  }
+
+  const auto test_duration = duration_cast<duration<double, nano>>( stop_time - start_time );
+  return test_duration.count() / static_cast<double>( acks );
+}
+
+// Measures the ack cost with each of `windows` outstanding. If an ack cost time in proportion to what is
+// outstanding, its cost would grow about as much as the window; allow no more than the square root of that
+// (cache misses on the bigger queue grow it some).
+void ack_tests( const initializer_list<uint16_t> windows, const bool sack, fstream& debug_output )
+{
+  vector<double> costs;
+  for ( const uint16_t window : windows ) {
+    const double ns_per_ack = ack_test( window, size_t { 1 } << 20, sack );
+    costs.push_back( ns_per_ack );
+
+    const string name = sack ? "TCPSender (SACK)" : "TCPSender";
+    cout << name << " with " << window << " segments outstanding took " << fixed << setprecision( 1 )
+         << ns_per_ack << " ns/ack.\n";
+    debug_output << "      " << name << " (window=" << setw( 5 ) << window << " segments) acks: " << fixed
+                 << setprecision( 1 ) << ns_per_ack << " ns/ack\n";
+  }
+
+  const double window_growth = static_cast<double>( *( windows.end() - 1 ) ) / *windows.begin();
+  if ( costs.back() > sqrt( window_growth ) * costs.front() ) {
+    throw runtime_error( "TCPSender per-ack cost grew with the number of outstanding segments." );
+  }
+}
+
+void program_body()
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  // The window grows 1000x, or (within the initial congestion window of ten full segments) 128x
+  ack_tests( { 1 << 6, 1 << 11, UINT16_MAX }, false, debug_output );
+  ack_tests( { 1 << 6, 1 << 10, 1 << 13 }, true, debug_output );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
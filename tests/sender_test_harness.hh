@@ -6,7 +6,10 @@
 #include "tcp_sender.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <optional>
+#include <queue>
 #include <sstream>
 #include <utility>
 
@@ -54,6 +57,48 @@ struct ExpectSeqnosInFlight : public ExpectNumber<StreamAndSender, uint64_t>
   uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.congestion_window(); }
+};
+
+struct ExpectSlowStartThreshold : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "slow_start_threshold"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.slow_start_threshold(); }
+};
+
+struct ExpectRTO : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rto_ms"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.rtt_estimator().rto_ms(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<StreamAndSender, std::optional<double>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "srtt_ms"; }
+  std::optional<double> value( StreamAndSender& ss ) const override { return ss.second.rtt_estimator().srtt_ms(); }
+};
+
+struct ExpectRTTVariation : public ExpectNumber<StreamAndSender, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rttvar_ms"; }
+  double value( StreamAndSender& ss ) const override { return ss.second.rtt_estimator().rttvar_ms(); }
+};
+
+struct ExpectNextSendTime : public ExpectNumber<StreamAndSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "next_send_time"; }
+  std::optional<uint64_t> value( StreamAndSender& ss ) const override { return ss.second.next_send_time(); }
+};
+
 struct ExpectNoSegment : public Expectation<StreamAndSender>
 {
   std::string description() const override { return "nothing to send"; }
@@ -154,19 +199,38 @@ struct Receive : public Action<StreamAndSender>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.sack ) {
+      desc << ", sack=[" << to_string( block.left ) << ", " << to_string( block.right ) << ")";
+    }
+    if ( msg_.timestamp_echo.has_value() ) {
+      desc << ", TSecr=" << msg_.timestamp_echo.value();
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
     return desc.str();
   }
 
-  Receive& with_win( uint16_t win )
+  Receive& with_win( uint32_t win )
   {
     msg_.window_size = win;
     return *this;
   }
 
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.push_back( { left, right } );
+    return *this;
+  }
+
+  Receive& with_timestamp_echo( uint32_t echo )
+  {
+    msg_.timestamp_echo = echo;
+    return *this;
+  }
+
   void execute( StreamAndSender& ss ) const override
   {
     ss.second.receive( msg_ );
@@ -182,6 +246,43 @@ struct Receive : public Action<StreamAndSender>
   }
 };
 
+struct PeerMSS : public Action<StreamAndSender>
+{
+  uint16_t mss_;
+
+  explicit PeerMSS( uint16_t mss ) : mss_( mss ) {}
+  std::string description() const override { return "peer advertises MSS=" + std::to_string( mss_ ); }
+  void execute( StreamAndSender& ss ) const override { ss.second.set_peer_mss( mss_ ); }
+};
+
+struct PeerTimestamps : public Action<StreamAndSender>
+{
+  bool agreed_;
+
+  explicit PeerTimestamps( bool agreed ) : agreed_( agreed ) {}
+  std::string description() const override
+  {
+    return std::string( "peer " ) + ( agreed_ ? "offers" : "doesn't offer" ) + " timestamps";
+  }
+  void execute( StreamAndSender& ss ) const override { ss.second.set_peer_timestamps( agreed_ ); }
+};
+
+struct SetCork : public Action<StreamAndSender>
+{
+  bool cork_;
+
+  explicit SetCork( bool cork ) : cork_( cork ) {}
+  std::string description() const override
+  {
+    return std::string( cork_ ? "cork" : "uncork" ) + ", then push stream to TCPSender";
+  }
+  void execute( StreamAndSender& ss ) const override
+  {
+    ss.second.set_cork( cork_ );
+    ss.second.push( ss.first.reader() );
+  }
+};
+
 struct AckReceived : public Receive
 {
   explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, DEFAULT_TEST_WINDOW } ) {}
@@ -199,6 +300,9 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<uint16_t> mss {};
+  std::optional<uint8_t> window_scale {};
+  std::optional<std::optional<uint32_t>> timestamp {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -239,6 +343,24 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     return *this;
   }
 
+  ExpectMessage& with_mss( uint16_t mss_ )
+  {
+    mss = mss_;
+    return *this;
+  }
+
+  ExpectMessage& with_window_scale( uint8_t window_scale_ )
+  {
+    window_scale = window_scale_;
+    return *this;
+  }
+
+  ExpectMessage& with_timestamp( std::optional<uint32_t> timestamp_ )
+  {
+    timestamp = timestamp_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -261,6 +383,19 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() ) {
       o << ( fin.value() ? " +FIN" : " (no FIN)" );
     }
+    if ( mss.has_value() ) {
+      o << " MSS=" << mss.value();
+    }
+    if ( window_scale.has_value() ) {
+      o << " WS=" << std::to_string( window_scale.value() );
+    }
+    if ( timestamp.has_value() ) {
+      if ( timestamp->has_value() ) {
+        o << " TSval=" << timestamp->value();
+      } else {
+        o << " (no timestamp)";
+      }
+    }
     return o.str();
   }
 
@@ -290,7 +425,18 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( mss.has_value() and seg.MSS != mss ) {
+      throw ExpectationViolation( "MSS option", mss, seg.MSS );
+    }
+    if ( window_scale.has_value() and seg.window_scale != window_scale ) {
+      throw ExpectationViolation( "window scale option", window_scale, seg.window_scale );
+    }
+    if ( timestamp.has_value() and seg.timestamp != timestamp.value() ) {
+      throw ExpectationViolation( "timestamp option", timestamp.value(), seg.timestamp );
+    }
+    const uint64_t max_payload
+      = ss.second.segmentation_offload() ? TCPConfig::MAX_OFFLOAD_SIZE : ss.second.mss();
+    if ( seg.payload.size() > max_payload ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -301,12 +447,127 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   }
 };
 
+// Run the sender for a while over a path with a bottleneck link (sending `bytes_per_ms`, with an unbounded
+// queue in front of it) and a fixed propagation delay, keeping the stream full and acking whatever arrives.
+// Over the second half of the run, the link should be busy at least `min_utilization` of the time, and no
+// segment should wait more than `max_queue_ms` in its queue.
+struct ExpectBottleneckUse : public Expectation<StreamAndSender>
+{
+  uint64_t duration_ms_;
+  uint64_t bytes_per_ms_;
+  uint64_t delay_ms_;
+  double min_utilization_;
+  uint64_t max_queue_ms_;
+
+  ExpectBottleneckUse( uint64_t duration_ms,
+                       uint64_t bytes_per_ms,
+                       uint64_t delay_ms,
+                       double min_utilization,
+                       uint64_t max_queue_ms )
+    : duration_ms_( duration_ms )
+    , bytes_per_ms_( bytes_per_ms )
+    , delay_ms_( delay_ms )
+    , min_utilization_( min_utilization )
+    , max_queue_ms_( max_queue_ms )
+  {}
+
+  std::string description() const override
+  {
+    std::ostringstream desc;
+    desc << "over " << duration_ms_ << " ms through a " << bytes_per_ms_ << " bytes/ms bottleneck with "
+         << delay_ms_ << " ms delay, the link is at least " << min_utilization_ * 100
+         << "% busy and queues at most " << max_queue_ms_ << " ms";
+    return desc.str();
+  }
+
+  void execute( StreamAndSender& ss ) const override
+  {
+    auto& [stream, sender] = ss;
+    std::optional<Wrap32> zero {};
+    std::queue<std::pair<uint64_t, uint64_t>> arrivals {}; // (when, end of segment) in flight to the receiver
+    double link_free_at = 0;
+    uint64_t next_ack = 0, delivered = 0;
+    double worst_queue = 0;
+
+    for ( uint64_t now = 0; now < duration_ms_; ++now ) {
+      const std::string data( stream.writer().available_capacity(), 'x' );
+      stream.writer().push( data );
+      sender.push( stream.reader() );
+      while ( auto msg = sender.maybe_send() ) {
+        if ( not zero.has_value() ) {
+          zero = msg->seqno;
+        }
+        const uint64_t start = msg->seqno.unwrap( zero.value(), next_ack );
+        const double wait = std::max( link_free_at - static_cast<double>( now ), 0.0 );
+        link_free_at = static_cast<double>( now ) + wait
+                       + static_cast<double>( msg->sequence_length() ) / static_cast<double>( bytes_per_ms_ );
+        arrivals.emplace( static_cast<uint64_t>( std::ceil( link_free_at ) ) + delay_ms_,
+                          start + msg->sequence_length() );
+        if ( now >= duration_ms_ / 2 ) {
+          worst_queue = std::max( worst_queue, wait );
+        }
+      }
+
+      sender.tick( 1 );
+      while ( not arrivals.empty() and arrivals.front().first <= now + 1 ) {
+        if ( arrivals.front().second > next_ack ) {
+          if ( now >= duration_ms_ / 2 ) {
+            delivered += arrivals.front().second - next_ack;
+          }
+          next_ack = arrivals.front().second;
+        }
+        arrivals.pop();
+        sender.receive( { Wrap32::wrap( next_ack, zero.value() ), UINT16_MAX } );
+      }
+    }
+
+    const uint64_t capacity = bytes_per_ms_ * ( duration_ms_ - duration_ms_ / 2 );
+    const double utilization = static_cast<double>( delivered ) / static_cast<double>( capacity );
+    if ( utilization < min_utilization_ ) {
+      throw ExpectationViolation( "link utilization of " + std::to_string( utilization * 100 )
+                                  + "%, below the expected minimum" );
+    }
+    if ( worst_queue > static_cast<double>( max_queue_ms_ ) ) {
+      throw ExpectationViolation( "a segment queued for " + std::to_string( worst_queue )
+                                  + " ms, more than the expected maximum" );
+    }
+  }
+};
+
 class TCPSenderTestHarness : public TestHarness<StreamAndSender>
 {
 public:
-  TCPSenderTestHarness( std::string name, TCPConfig config )
+  // The sender tests exercise the sliding window on its own, with a fixed initial timeout, unless they ask for
+  // a congestion controller or for round-trip time estimation
+  TCPSenderTestHarness( std::string name,
+                        TCPConfig config,
+                        CongestionControl congestion_control = CongestionControl::None,
+                        bool estimate_rto = false )
     : TestHarness( move( name ),
-                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
+                   "initial_RTO_ms=" + to_string( config.rt_timeout ) + describe( congestion_control )
+                     + ( estimate_rto ? ", RTO estimation" : "" ),
+                   { ByteStream { config.send_capacity, config.send_storage },
+                     TCPSender { with_options( config, congestion_control, estimate_rto ) } } )
   {}
+
+  static TCPConfig with_options( TCPConfig config, CongestionControl congestion_control, bool estimate_rto )
+  {
+    config.congestion_control = congestion_control;
+    config.estimate_rto = estimate_rto;
+    return config;
+  }
+
+  static std::string describe( CongestionControl congestion_control )
+  {
+    switch ( congestion_control ) {
+      case CongestionControl::NewReno:
+        return ", NewReno";
+      case CongestionControl::Cubic:
+        return ", CUBIC";
+      case CongestionControl::Bbr:
+        return ", BBR";
+      default:
+        return "";
+    }
+  }
 };
@@ -0,0 +1,225 @@
+#include "address.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+TCPSegment roundtrip( TCPSegment seg )
+{
+  seg.compute_checksum( 0 );
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( seg ), 0 ) ) {
+    throw runtime_error( "failed to parse a serialized TCPSegment" );
+  }
+  return parsed;
+}
+
+void check( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "TCPSegment option round trip: " + what );
+  }
+}
+
+// Wrap a segment in an IPv4 datagram from one end, put it on the wire, and unwrap it at the other
+TCPSegment roundtrip_over_ip( TCPSegment seg )
+{
+  TCPOverIPv4Adapter sender;
+  sender.config_mut().source = Address { "10.0.0.1", 1234 };
+  sender.config_mut().destination = Address { "10.0.0.2", 80 };
+  TCPOverIPv4Adapter receiver;
+  receiver.config_mut().source = sender.config().destination;
+  receiver.config_mut().destination = sender.config().source;
+
+  const auto wire = serialize( sender.wrap_tcp_in_ip( seg ) );
+  const size_t wire_length = accumulate(
+    wire.begin(), wire.end(), size_t { 0 }, []( size_t sum, const Buffer& b ) { return sum + b.size(); } );
+  InternetDatagram dgram;
+  check( parse( dgram, wire ), "datagram didn't parse" );
+  check( dgram.header.len == wire_length, "IPv4 length doesn't count the options" );
+  const auto parsed = receiver.unwrap_tcp_in_ip( dgram );
+  check( parsed.has_value(), "segment didn't unwrap (bad length or checksum?)" );
+  return parsed.value();
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPSegment syn;
+      syn.sender_message.seqno = Wrap32( rd() );
+      syn.sender_message.SYN = true;
+      syn.sender_message.SACK_permitted = true;
+      const auto parsed = roundtrip( syn );
+      check( parsed.sender_message.SYN and parsed.sender_message.SACK_permitted, "SACK-permitted lost" );
+      check( parsed.sender_message.payload.empty(), "options read as payload" );
+    }
+
+    {
+      TCPSegment syn;
+      syn.sender_message.SYN = true;
+      const auto parsed = roundtrip( syn );
+      check( not parsed.sender_message.SACK_permitted, "SACK-permitted appeared from nowhere" );
+      check( not parsed.sender_message.MSS.has_value(), "MSS appeared from nowhere" );
+    }
+
+    {
+      TCPSegment syn;
+      syn.sender_message.seqno = Wrap32( rd() );
+      syn.sender_message.SYN = true;
+      syn.sender_message.MSS = TCPConfig::mss_for_mtu( 9000 );
+      syn.sender_message.SACK_permitted = true;
+      const auto parsed = roundtrip( syn );
+      check( parsed.sender_message.MSS == TCPConfig::mss_for_mtu( 9000 ), "MSS lost or changed" );
+      check( parsed.sender_message.SACK_permitted, "SACK-permitted lost after MSS" );
+      check( parsed.sender_message.payload.empty(), "options read as payload" );
+    }
+
+    {
+      // Through the IP layer, the options count towards the datagram's length and the pseudo-header checksum
+      TCPSegment syn;
+      syn.sender_message.seqno = Wrap32( rd() );
+      syn.sender_message.SYN = true;
+      syn.sender_message.SACK_permitted = true;
+      syn.sender_message.MSS = 1460;
+      syn.sender_message.payload = string( "data on a SYN" );
+      const auto parsed = roundtrip_over_ip( syn );
+      check( parsed.sender_message.SYN and parsed.sender_message.SACK_permitted, "SACK-permitted lost" );
+      check( parsed.sender_message.MSS == 1460, "MSS lost or changed" );
+      check( string_view { parsed.sender_message.payload } == "data on a SYN", "payload changed" );
+
+      TCPSegment ack;
+      ack.receiver_message.ackno = Wrap32( rd() );
+      ack.receiver_message.sack.push_back( { ack.receiver_message.ackno.value() + 1000,
+                                             ack.receiver_message.ackno.value() + 2000 } );
+      const auto parsed_ack = roundtrip_over_ip( ack );
+      check( parsed_ack.receiver_message.sack.size() == 1
+               and parsed_ack.receiver_message.sack[0] == ack.receiver_message.sack[0],
+             "SACK block lost or changed" );
+    }
+
+    {
+      // The MSS option only means anything on a SYN
+      TCPSegment seg;
+      seg.sender_message.MSS = 1460;
+      seg.sender_message.payload = string( "data" );
+      const auto parsed = roundtrip( seg );
+      check( not parsed.sender_message.MSS.has_value(), "MSS sent without SYN" );
+      check( string_view { parsed.sender_message.payload } == "data", "payload changed" );
+    }
+
+    {
+      TCPSegment syn;
+      syn.sender_message.seqno = Wrap32( rd() );
+      syn.sender_message.SYN = true;
+      syn.sender_message.MSS = 1460;
+      syn.sender_message.window_scale = 7;
+      syn.sender_message.SACK_permitted = true;
+      const auto parsed = roundtrip( syn );
+      check( parsed.sender_message.window_scale == 7, "window scale lost or changed" );
+      check( parsed.sender_message.MSS == 1460 and parsed.sender_message.SACK_permitted, "other options lost" );
+      check( parsed.sender_message.payload.empty(), "options read as payload" );
+    }
+
+    {
+      // The window scale option only goes on a SYN; the window field itself is never more than 16 bits
+      TCPSegment seg;
+      seg.sender_message.window_scale = 7;
+      seg.receiver_message.ackno = Wrap32( rd() );
+      seg.receiver_message.window_size = 1'000'000;
+      const auto parsed = roundtrip( seg );
+      check( not parsed.sender_message.window_scale.has_value(), "window scale sent without SYN" );
+      check( parsed.receiver_message.window_size == UINT16_MAX, "oversized window not clamped" );
+    }
+
+    {
+      // A SYN offers timestamps with an echo of zero, which isn't read back without an ack
+      TCPSegment syn;
+      syn.sender_message.seqno = Wrap32( rd() );
+      syn.sender_message.SYN = true;
+      syn.sender_message.MSS = 1460;
+      syn.sender_message.timestamp = 123456;
+      syn.sender_message.window_scale = 7;
+      syn.sender_message.SACK_permitted = true;
+      const auto parsed = roundtrip( syn );
+      check( parsed.sender_message.timestamp == 123456, "timestamp lost or changed" );
+      check( not parsed.receiver_message.timestamp_echo.has_value(), "echo read from a segment without an ack" );
+      check( parsed.sender_message.window_scale == 7 and parsed.sender_message.SACK_permitted,
+             "other options lost" );
+      check( parsed.sender_message.payload.empty(), "options read as payload" );
+    }
+
+    {
+      TCPSegment seg;
+      seg.sender_message.seqno = Wrap32( rd() );
+      seg.sender_message.payload = string( "data" );
+      seg.sender_message.timestamp = UINT32_MAX;
+      seg.receiver_message.ackno = Wrap32( rd() );
+      seg.receiver_message.timestamp_echo = 42;
+      const auto parsed = roundtrip( seg );
+      check( parsed.sender_message.timestamp == UINT32_MAX, "timestamp lost or changed" );
+      check( parsed.receiver_message.timestamp_echo == 42, "timestamp echo lost or changed" );
+      check( string_view { parsed.sender_message.payload } == "data", "payload changed" );
+    }
+
+    {
+      // With timestamps, there's only room for three SACK blocks
+      TCPSegment ack;
+      ack.sender_message.timestamp = 1000;
+      ack.receiver_message.ackno = Wrap32( rd() );
+      ack.receiver_message.timestamp_echo = 900;
+      for ( size_t i = 0; i < TCPReceiverMessage::MAX_SACK_BLOCKS; ++i ) {
+        const Wrap32 left( rd() );
+        ack.receiver_message.sack.push_back( { left, left + 1000 } );
+      }
+      const auto parsed = roundtrip( ack );
+      check( parsed.receiver_message.sack.size() == TCPReceiverMessage::MAX_SACK_BLOCKS_TS,
+             "wrong number of blocks" );
+      for ( size_t i = 0; i < TCPReceiverMessage::MAX_SACK_BLOCKS_TS; ++i ) {
+        check( parsed.receiver_message.sack[i] == ack.receiver_message.sack[i], "SACK block changed" );
+      }
+      check( parsed.receiver_message.timestamp_echo == 900, "timestamp echo lost or changed" );
+    }
+
+    {
+      TCPSegment ack;
+      ack.receiver_message.ackno = Wrap32( rd() );
+      for ( size_t i = 0; i < TCPReceiverMessage::MAX_SACK_BLOCKS + 1; ++i ) {
+        const Wrap32 left( rd() );
+        ack.receiver_message.sack.push_back( { left, left + 1000 } );
+      }
+      ack.sender_message.payload = string( "payload after the options" );
+      const auto parsed = roundtrip( ack );
+
+      // Only as many blocks as fit in the header are sent
+      check( parsed.receiver_message.sack.size() == TCPReceiverMessage::MAX_SACK_BLOCKS, "wrong number of blocks" );
+      for ( size_t i = 0; i < TCPReceiverMessage::MAX_SACK_BLOCKS; ++i ) {
+        check( parsed.receiver_message.sack[i] == ack.receiver_message.sack[i], "SACK block changed" );
+      }
+      check( string_view { parsed.sender_message.payload } == "payload after the options", "payload changed" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include "address.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "random.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void check( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "Segmentation offload: " + what );
+  }
+}
+
+// Parse the TCP segment back out of a datagram, checking the length and checksums along the way
+TCPSegment unwrap( const InternetDatagram& dgram )
+{
+  const auto wire = serialize( dgram );
+  const size_t wire_length = accumulate(
+    wire.begin(), wire.end(), size_t { 0 }, []( size_t sum, const Buffer& b ) { return sum + b.size(); } );
+  check( dgram.header.len == wire_length, "IPv4 length doesn't match the datagram" );
+
+  InternetDatagram parsed_dgram;
+  check( parse( parsed_dgram, wire ), "datagram didn't parse" );
+  TCPSegment seg;
+  check( parse( seg, parsed_dgram.payload, parsed_dgram.header.pseudo_checksum() ), "TCP segment didn't parse" );
+  return seg;
+}
+
+TCPOverIPv4Adapter make_adapter()
+{
+  TCPOverIPv4Adapter adapter;
+  adapter.config_mut().source = Address { "10.0.0.1", 1234 };
+  adapter.config_mut().destination = Address { "10.0.0.2", 80 };
+  return adapter;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      // A burst of 3500 bytes with the FIN and SACK blocks becomes four packets
+      auto adapter = make_adapter();
+      const Wrap32 seqno( rd() );
+      const Wrap32 ackno( rd() );
+      string data;
+      for ( size_t i = 0; i < 3500; ++i ) {
+        data.push_back( static_cast<char>( 'a' + i % 26 ) );
+      }
+
+      TCPSegment burst;
+      burst.sender_message.seqno = seqno;
+      burst.sender_message.payload = string( data );
+      burst.sender_message.FIN = true;
+      burst.receiver_message.ackno = ackno;
+      burst.receiver_message.window_size = 5000;
+      burst.receiver_message.sack.push_back( { ackno + 2000, ackno + 3000 } );
+      burst.segment_size = 1000;
+
+      const auto dgrams = adapter.wrap_tcp_in_ip_segments( burst );
+      check( dgrams.size() == 4, "wrong number of packets" );
+      for ( size_t i = 0; i < dgrams.size(); ++i ) {
+        const auto seg = unwrap( dgrams[i] );
+        const size_t offset = i * 1000;
+        check( seg.sender_message.seqno == seqno + static_cast<uint32_t>( offset ), "wrong seqno" );
+        check( string_view { seg.sender_message.payload } == string_view { data }.substr( offset, 1000 ),
+               "wrong payload" );
+        check( seg.sender_message.FIN == ( i == dgrams.size() - 1 ), "FIN not on the last packet alone" );
+        check( seg.receiver_message.ackno == ackno and seg.receiver_message.window_size == 5000,
+               "receiver fields not copied" );
+        check( seg.receiver_message.sack == burst.receiver_message.sack, "SACK blocks not copied" );
+        check( seg.udinfo.src_port == 1234 and seg.udinfo.dst_port == 80, "wrong ports" );
+      }
+    }
+
+    {
+      // The SYN takes the first sequence number, and goes only on the first packet
+      auto adapter = make_adapter();
+      const Wrap32 isn( rd() );
+      TCPSegment burst;
+      burst.sender_message.seqno = isn;
+      burst.sender_message.SYN = true;
+      burst.sender_message.MSS = 1000;
+      burst.sender_message.payload = string( 1500, 'x' );
+      burst.segment_size = 1000;
+
+      const auto dgrams = adapter.wrap_tcp_in_ip_segments( burst );
+      check( dgrams.size() == 2, "wrong number of packets" );
+      const auto first = unwrap( dgrams[0] );
+      const auto second = unwrap( dgrams[1] );
+      check( first.sender_message.SYN and first.sender_message.MSS == 1000, "SYN or its options lost" );
+      check( not second.sender_message.SYN and not second.sender_message.MSS.has_value(), "SYN repeated" );
+      check( second.sender_message.seqno == isn + 1001, "wrong seqno after the SYN" );
+      check( second.sender_message.payload.size() == 500, "wrong size of the last packet" );
+    }
+
+    {
+      // An ordinary segment is one datagram, even with segment_size set
+      auto adapter = make_adapter();
+      TCPSegment seg;
+      seg.sender_message.seqno = Wrap32( rd() );
+      seg.sender_message.payload = string( 1000, 'y' );
+      seg.segment_size = 1000;
+      const auto dgrams = adapter.wrap_tcp_in_ip_segments( seg );
+      check( dgrams.size() == 1, "segment was split" );
+      check( unwrap( dgrams[0] ).sender_message.payload.size() == 1000, "payload changed" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
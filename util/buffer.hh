@@ -2,22 +2,46 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 class Buffer
 {
   std::shared_ptr<std::string> buffer_;
+  size_t offset_ {};                         // start of this Buffer's bytes within *buffer_
+  size_t length_ { std::string_view::npos }; // how many bytes (npos = through the end of *buffer_)
+
+  // Give a slice, or a string other Buffers share, its own copy, so that mutable access can't disturb them
+  std::string& own()
+  {
+    if ( offset_ or length_ != std::string_view::npos or buffer_.use_count() > 1 ) {
+      buffer_ = std::make_shared<std::string>( std::string_view { *this } );
+      offset_ = 0;
+      length_ = std::string_view::npos;
+    }
+    return *buffer_;
+  }
 
 public:
   // NOLINTBEGIN(*-explicit-*)
 
   Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  operator std::string_view() const { return std::string_view { *buffer_ }.substr( offset_, length_ ); }
+  operator std::string&() { return own(); }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  // A Buffer referring to (not copying) `len` bytes of this one, starting at `pos`
+  Buffer slice( size_t pos, size_t len = std::string_view::npos ) const
+  {
+    Buffer ret { *this };
+    const auto view = std::string_view { *this }.substr( pos, len );
+    ret.offset_ = offset_ + pos;
+    ret.length_ = view.size();
+    return ret;
+  }
+
+  std::string&& release() { return std::move( own() ); }
+  size_t size() const { return std::string_view { *this }.size(); }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
 };
@@ -37,6 +37,11 @@ public:
   //! \returns a mutable reference
   FdAdapterConfig& config_mut() { return _cfg; }
 
+  //! \brief Install a new configuration (an adapter that keeps settings of its own, like the MTU, hides this to
+  //! apply them)
+  //! \param[in] cfg is the new configuration
+  void set_config( const FdAdapterConfig& cfg ) { _cfg = cfg; }
+
   //! Called periodically when time elapses
   void tick( const size_t unused [[maybe_unused]] ) {}
 };
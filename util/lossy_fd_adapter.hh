@@ -50,6 +50,7 @@ public:
   }
 
   //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
+  //! (a segmentation-offload burst is dropped or written as a whole)
   //! \param[in] seg is the packet to either write or drop
   void write( TCPSegment& seg )
   {
@@ -65,5 +66,7 @@ public:
   void set_listening( const bool l ) { _adapter.set_listening( l ); } //!< FdAdapterBase::set_listening passthrough
   const FdAdapterConfig& config() const { return _adapter.config(); } //!< FdAdapterBase::config passthrough
   FdAdapterConfig& config_mut() { return _adapter.config_mut(); }     //!< FdAdapterBase::config_mut passthrough
+  //! AdapterT::set_config passthrough
+  void set_config( const FdAdapterConfig& cfg ) { _adapter.set_config( cfg ); }
   void tick( const size_t ms_since_last_tick ) { _adapter.tick( ms_since_last_tick ); }
 };
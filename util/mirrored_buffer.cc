@@ -0,0 +1,72 @@
+#include "mirrored_buffer.hh"
+
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+MirroredBuffer::MirroredBuffer( const size_t min_size )
+{
+  const auto page_size = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+  const size_t size = max( size_t { 1 }, ( min_size + page_size - 1 ) / page_size ) * page_size;
+
+  // The memfd is only needed until both views are mapped; FileDescriptor closes it on the way out.
+  const FileDescriptor memfd { CheckSystemCall( "memfd_create", memfd_create( "minnow-ring", MFD_CLOEXEC ) ) };
+  CheckSystemCall( "ftruncate", ftruncate( memfd.fd_num(), static_cast<off_t>( size ) ) );
+
+  // Reserve enough contiguous address space for both views, then map the memfd over each half.
+  void* const region = mmap( nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( region == MAP_FAILED ) {
+    throw unix_error { "mmap" };
+  }
+  data_ = static_cast<char*>( region );
+  size_ = size;
+
+  for ( char* const view : { data_, data_ + size_ } ) {
+    if ( mmap( view, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num(), 0 ) == MAP_FAILED ) {
+      const unix_error error { "mmap" };
+      unmap();
+      throw error;
+    }
+  }
+}
+
+void MirroredBuffer::unmap()
+{
+  if ( data_ ) {
+    munmap( data_, 2 * size_ );
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+MirroredBuffer::MirroredBuffer( const MirroredBuffer& other ) : MirroredBuffer( other.size_ )
+{
+  if ( other.data_ ) {
+    memcpy( data_, other.data_, other.size_ );
+  }
+}
+
+MirroredBuffer& MirroredBuffer::operator=( const MirroredBuffer& other )
+{
+  if ( this != &other ) {
+    *this = MirroredBuffer { other };
+  }
+  return *this;
+}
+
+MirroredBuffer::MirroredBuffer( MirroredBuffer&& other ) noexcept
+  : data_( exchange( other.data_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+MirroredBuffer& MirroredBuffer::operator=( MirroredBuffer&& other ) noexcept
+{
+  swap( data_, other.data_ );
+  swap( size_, other.size_ );
+  return *this;
+}
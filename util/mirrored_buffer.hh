@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+//! A region of `size()` bytes whose pages are mapped twice, back to back, so that `data()[i]` and
+//! `data()[i + size()]` are the same byte. A ring buffer stored here can treat any run of up to `size()`
+//! bytes as one contiguous range, no matter where it wraps.
+class MirroredBuffer
+{
+  char* data_ {};   //!< Start of the 2 * size_ bytes of address space
+  size_t size_ {}; //!< Length of the underlying (shared) memory, a whole number of pages
+
+  void unmap();
+
+public:
+  //! Map at least `min_size` bytes (rounded up to whole pages). Throws unix_error if the kernel refuses.
+  explicit MirroredBuffer( size_t min_size );
+  ~MirroredBuffer() { unmap(); }
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  //! Copies get their own mapping (with the same contents); moves hand the mapping over.
+  MirroredBuffer( const MirroredBuffer& other );
+  MirroredBuffer& operator=( const MirroredBuffer& other );
+  MirroredBuffer( MirroredBuffer&& other ) noexcept;
+  MirroredBuffer& operator=( MirroredBuffer&& other ) noexcept;
+};
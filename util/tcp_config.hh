@@ -1,8 +1,12 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "tcp_receiver_message.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -11,14 +15,90 @@
 class TCPConfig
 {
 public:
-  static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-  static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size (default MSS)
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
+  static constexpr uint64_t MIN_RTO_DFLT = 200;      //!< Default floor on a measured re-transmit timeout
+  static constexpr uint64_t MAX_RTO_DFLT = 60000;    //!< Default ceiling on the re-transmit timeout
+  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+  static constexpr uint64_t IDLE_SHRINK_DFLT = 5000; //!< Default idle time before stream memory is released
+  static constexpr size_t MAX_OFFLOAD_SIZE = 65536;  //!< Largest payload handed to an adapter to split
+  static constexpr uint64_t MAX_ACK_DELAY = 200;     //!< Longest a receiver is expected to delay an ack, in ms
+  static constexpr uint64_t ACK_DELAY_DFLT = 40;     //!< Default delay of an ack that may wait, in ms
+  static constexpr uint16_t DEFAULT_PEER_MSS = 536;  //!< A peer's MSS if its SYN doesn't say (RFC 9293 3.7.1)
+
+  static constexpr uint16_t IPV4_HEADER_LENGTH = 20;    //!< Without options
+  static constexpr uint16_t MAX_TCP_HEADER_LENGTH = 60; //!< With 40 bytes of options
+
+  //! The most receive-buffer auto-tuning may add to the receive capacity of all connections together
+  static constexpr uint64_t MAX_AUTOTUNED_TOTAL = 64 * 1024 * 1024;
+
+  //! The smallest window scale that lets a window of `capacity` bytes be advertised in full (or the largest
+  //! scale, if none does)
+  static constexpr uint8_t window_shift_for( uint64_t capacity )
+  {
+    uint8_t shift = 0;
+    while ( shift < TCPReceiverMessage::MAX_WINDOW_SHIFT and ( capacity >> shift ) > UINT16_MAX ) {
+      ++shift;
+    }
+    return shift;
+  }
+
+  //! The largest payload that fits a link's MTU, leaving room for the IPv4 header and a TCP header with the
+  //! most options it can carry (but at least one byte, however small the MTU)
+  static constexpr uint16_t mss_for_mtu( uint16_t mtu )
+  {
+    constexpr uint16_t headers = IPV4_HEADER_LENGTH + MAX_TCP_HEADER_LENGTH;
+    return mtu > headers ? static_cast<uint16_t>( mtu - headers ) : 1;
+  }
+
+  //! The most the receive capacity can become (with auto-tuning, it may grow past recv_capacity)
+  size_t max_recv_capacity() const { return std::max( recv_capacity, recv_capacity_max.value_or( 0 ) ); }
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
+  //! Adapt the retransmission timeout to measured round-trip times (RFC 6298), within [min_rto, max_rto]
+  bool estimate_rto = true;
+  uint64_t min_rto = MIN_RTO_DFLT;
+  uint64_t max_rto = MAX_RTO_DFLT;
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
+  //! Receive-buffer auto-tuning (like Linux's dynamic right-sizing): starting from recv_capacity, grow the receive
+  //! capacity (and so the window) to twice what the application reads per round trip, up to this many bytes, and
+  //! go back to recv_capacity when the connection idles. Unset, the receive capacity stays fixed.
+  std::optional<size_t> recv_capacity_max {};
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  //! Layout of the outbound stream (Rope lets the sender share application Buffers instead of copying them)
+  ByteStream::Storage send_storage = ByteStream::Storage::Flat;
+  uint64_t idle_shrink_ms = IDLE_SHRINK_DFLT; //!< Idle time (no bytes in or out) before streams give back memory
+  //! Not-sent low watermark (like TCP_NOTSENT_LOWAT): the application may write only while fewer unsent bytes
+  //! than this are waiting in the outbound stream
+  std::optional<uint64_t> send_low_watermark {};
+  CongestionControl congestion_control = CongestionControl::NewReno; //!< How the sender reacts to congestion
+  bool sack = true; //!< Offer selective acknowledgments (RFC 2018), and use them if the peer does too
+  //! Maximum segment size: the largest payload to send, and the one advertised (in the MSS option) as the
+  //! largest to receive. If unset, MAX_PAYLOAD_SIZE, or what the link's MTU allows when connecting through
+  //! an adapter. The sender's segments are also held to the peer's advertised MSS.
+  std::optional<uint16_t> mss {};
+  //! Segmentation offload (like TSO): send up to MAX_OFFLOAD_SIZE bytes as one segment, which the adapter
+  //! splits into MSS-sized packets. Outstanding data is still tracked, and retransmitted, an MSS at a time.
+  bool segmentation_offload = false;
+  //! Like TCP_NODELAY: send less-than-full segments right away. If false, Nagle's algorithm (RFC 896) holds one
+  //! back while earlier data is unacknowledged, so small writes coalesce into fuller segments.
+  bool nodelay = true;
+  //! Offer window scaling (RFC 7323), so that a recv_capacity above 64 KiB (up to about 1 GiB) can be advertised
+  //! in full. Windows are scaled only if the peer offers it too.
+  bool window_scaling = true;
+  //! Offer timestamps (RFC 7323): an RTT sample from every ack of new data (retransmitted or not), and PAWS,
+  //! which drops old duplicates once the sequence numbers have wrapped. Used only if the peer offers them too.
+  bool timestamps = true;
+  //! RACK-TLP (RFC 8985): deem a segment lost once one sent after it has arrived and a little more than a round
+  //! trip has passed, and probe with the last segment about two round trips after the last transmission, so a
+  //! loss at the tail of a burst is repaired by SACK recovery rather than a timeout. Needs estimate_rto, a
+  //! congestion controller and a peer that sends SACKs.
+  bool rack_tlp = true;
+  //! Delayed acks (RFC 1122): acknowledge in-order data after every second full segment, or once an ack has
+  //! waited this many milliseconds (TCPPeer cuts it to MAX_ACK_DELAY), unless outgoing data carries it first.
+  //! Out-of-order data, a FIN and a SYN are acked at once. Zero acks every segment at once.
+  uint64_t ack_delay = ACK_DELAY_DFLT;
   std::optional<Wrap32> fixed_isn {};
 };
 
@@ -29,6 +109,11 @@ public:
   Address source { "0", 0 };      //!< Source address and port
   Address destination { "0", 0 }; //!< Destination address and port
 
-  uint16_t loss_rate_dn = 0; //!< Downlink loss rate (for LossyFdAdapter)
-  uint16_t loss_rate_up = 0; //!< Uplink loss rate (for LossyFdAdapter)
+  static constexpr uint16_t DEFAULT_MTU = 1500; //!< Ethernet's
+  //! Smallest MTU with room for the largest IPv4 and TCP headers and a byte of payload
+  static constexpr uint16_t MIN_MTU = TCPConfig::IPV4_HEADER_LENGTH + TCPConfig::MAX_TCP_HEADER_LENGTH + 1;
+
+  uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
+  uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+  uint16_t mtu = DEFAULT_MTU; //!< Largest IP datagram the link carries (e.g. 9000 with jumbo frames)
 };
@@ -5,6 +5,7 @@
 #include "parser.hh"
 #include "tun.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -33,7 +34,15 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const function<bool()>& condition )
 {
   auto base_time = timestamp_ms();
   while ( condition() ) {
-    auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
+    // Wake up early if the sender is pacing out data and its next release is due before the next tick
+    int timeout_ms = TCP_TICK_MS;
+    if ( _tcp.has_value() ) {
+      if ( const auto next_send = _tcp->next_send_time(); next_send.has_value() ) {
+        timeout_ms = static_cast<int>( min( next_send.value(), uint64_t { TCP_TICK_MS } ) );
+      }
+    }
+
+    auto ret = _eventloop.wait_next_event( timeout_ms );
     if ( ret == EventLoop::Result::Exit or _abort ) {
       break;
     }
@@ -42,6 +51,8 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const function<bool()>& condition )
       throw runtime_error( "_tcp_loop entered before TCPPeer initialized" );
     }
 
+    _apply_cork();
+
     if ( _tcp.value().active() ) {
       const auto next_time = timestamp_ms();
       _tcp.value().tick( next_time - base_time );
@@ -68,7 +79,16 @@ TCPMinnowSocket<AdaptT>::TCPMinnowSocket( pair<FileDescriptor, FileDescriptor> d
 template<typename AdaptT>
 void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
 {
-  _tcp.emplace( config );
+  // Unless told otherwise, use segments as large as the link allows
+  TCPConfig tcp_config = config;
+  if ( not tcp_config.mss.has_value() ) {
+    tcp_config.mss = TCPConfig::mss_for_mtu( _datagram_adapter.config().mtu );
+  }
+  _tcp.emplace( tcp_config );
+
+  // Track the outbound stream's readiness as it changes, rather than re-checking its capacity on every poll
+  _outbound_writable = _tcp->outbound_writer().available_capacity() > 0;
+  _tcp->outbound_writer().set_writable_callback( [&]( bool writable ) { _outbound_writable = writable; } );
 
   // Set up the event loop
 
@@ -114,10 +134,10 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _thread_data,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      // Cork first: the owner may have corked just before this write, in which case it mustn't go out alone
+      _apply_cork();
+      Writer& outbound = _tcp->outbound_writer();
+      outbound.commit( _thread_data.read_into( outbound.reserve() ) );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -133,8 +153,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       collect_segments();
     },
     [&] {
-      return ( _tcp->active() ) and ( not _outbound_shutdown )
-             and ( _tcp->outbound_writer().available_capacity() > 0 );
+      return ( _tcp->active() ) and ( not _outbound_shutdown ) and _outbound_writable;
     },
     [&] {
       _tcp->outbound_writer().close();
@@ -152,8 +171,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_all() );
         inbound.pop( bytes_written );
       }
 
@@ -237,16 +255,16 @@ void TCPMinnowSocket<AdaptT>::connect( const TCPConfig& c_tcp, const FdAdapterCo
     throw runtime_error( "connect() with TCPConnection already initialized" );
   }
 
+  _datagram_adapter.set_config( c_ad );
   _initialize_TCP( c_tcp );
 
-  _datagram_adapter.config_mut() = c_ad;
-
   cerr << "DEBUG: Connecting to " << c_ad.destination.to_string() << "...\n";
 
   if ( not _tcp.has_value() ) {
     throw runtime_error( "TCPPeer not successfully initialized" );
   }
 
+  _apply_cork();
   _tcp->push();
   collect_segments();
 
@@ -273,9 +291,8 @@ void TCPMinnowSocket<AdaptT>::listen_and_accept( const TCPConfig& c_tcp, const F
     throw runtime_error( "listen_and_accept() with TCPConnection already initialized" );
   }
 
+  _datagram_adapter.set_config( c_ad );
   _initialize_TCP( c_tcp );
-
-  _datagram_adapter.config_mut() = c_ad;
   _datagram_adapter.set_listening( true );
 
   cerr << "DEBUG: Listening for incoming connection...\n";
@@ -305,6 +322,15 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
   }
 }
 
+template<typename AdaptT>
+void TCPMinnowSocket<AdaptT>::_apply_cork()
+{
+  if ( _tcp.has_value() and _tcp->sender().corked() != _corked ) {
+    _tcp->set_cork( _corked );
+    collect_segments();
+  }
+}
+
 template<typename AdaptT>
 void TCPMinnowSocket<AdaptT>::collect_segments()
 {
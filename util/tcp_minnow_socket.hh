@@ -60,8 +60,14 @@ private:
 
   bool _fully_acked { false }; //!< Has the outbound data been fully acknowledged by the peer?
 
+  bool _outbound_writable { true }; //!< Does the outbound stream have capacity (below its low watermark)?
+
+  std::atomic_bool _corked { false }; //!< Set by the owner (cork()/uncork()), applied by the TCPPeer thread
+
   void collect_segments(); //!< Drain segments from the TCPPeer
 
+  void _apply_cork(); //!< Bring the TCPPeer's cork up to date with cork()/uncork(), before it's given more to send
+
 public:
   //! Construct from the interface that the TCPPeer thread will use to read and write datagrams
   explicit TCPMinnowSocket( AdaptT&& datagram_interface );
@@ -77,6 +83,13 @@ public:
   //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
   void listen_and_accept( const TCPConfig& c_tcp, const FdAdapterConfig& c_ad );
 
+  //! Like TCP_CORK: send only full segments until uncork(), so that small writes coalesce. Takes effect
+  //! before any later write is sent (and otherwise within a tick of the TCPPeer thread).
+  void cork() { _corked = true; }
+
+  //! Send whatever cork() held back
+  void uncork() { _corked = false; }
+
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
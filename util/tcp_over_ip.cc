@@ -4,6 +4,7 @@
 #include "ipv4_header.hh"
 #include "parser.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <stdexcept>
 #include <unistd.h>
@@ -84,7 +85,7 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( TCPSegment& seg )
   InternetDatagram ip_dgram;
   ip_dgram.header.src = config().source.ipv4_numeric();
   ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.sender_message.payload.size();
+  ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.sender_message.payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
   seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
@@ -93,3 +94,31 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( TCPSegment& seg )
 
   return ip_dgram;
 }
+
+//! \details A segment without `segment_size` set (or with a payload that already fits) becomes one datagram.
+//! Otherwise, each packet starts as a copy of the burst's headers (ports, ackno, window, SACK blocks, RST)
+//! and gets its own seqno and slice of the payload. The SYN goes only on the first packet, the FIN only on
+//! the last.
+//! \param[in] seg is the TCP segment to convert
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip_segments( TCPSegment& seg )
+{
+  const Buffer& payload = seg.sender_message.payload;
+  if ( seg.segment_size == 0 or payload.size() <= seg.segment_size ) {
+    return { wrap_tcp_in_ip( seg ) };
+  }
+
+  vector<InternetDatagram> dgrams;
+  dgrams.reserve( ( payload.size() + seg.segment_size - 1 ) / seg.segment_size );
+  TCPSegment piece = seg;
+  piece.segment_size = 0;
+  for ( size_t offset = 0; offset < payload.size(); offset += seg.segment_size ) {
+    const size_t size = min( seg.segment_size, payload.size() - offset );
+    piece.sender_message.seqno
+      = seg.sender_message.seqno + static_cast<uint32_t>( seg.sender_message.SYN + offset );
+    piece.sender_message.SYN = seg.sender_message.SYN and offset == 0;
+    piece.sender_message.FIN = seg.sender_message.FIN and offset + size == payload.size();
+    piece.sender_message.payload = payload.slice( offset, size );
+    dgrams.push_back( wrap_tcp_in_ip( piece ) );
+  }
+  return dgrams;
+}
@@ -6,6 +6,7 @@
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase
@@ -14,4 +15,7 @@ public:
   std::optional<TCPSegment> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram );
 
   InternetDatagram wrap_tcp_in_ip( TCPSegment& seg );
+
+  //! Like wrap_tcp_in_ip, but first splits a segmentation-offload burst into packets of `seg.segment_size`
+  std::vector<InternetDatagram> wrap_tcp_in_ip_segments( TCPSegment& seg );
 };
@@ -7,27 +7,152 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <atomic>
 #include <optional>
 
 class TCPPeer
 {
   TCPConfig cfg_;
-  TCPSender sender_ { cfg_.rt_timeout, cfg_.fixed_isn };
+  TCPSender sender_ { cfg_ };
   TCPReceiver receiver_ {};
-  Reassembler reassembler_ {};
+  Reassembler reassembler_ { Reassembler::Placement::Direct };
 
-  ByteStream outbound_stream_ { cfg_.send_capacity }, inbound_stream_ { cfg_.recv_capacity };
+  ByteStream outbound_stream_ { cfg_.send_capacity, cfg_.send_storage }, inbound_stream_ { cfg_.recv_capacity };
 
   bool need_send_ {};
 
+  // Window scaling (RFC 7323), in effect once both SYNs have carried the option. Windows on SYNs aren't scaled.
+  uint8_t recv_window_shift_ {}; // How far the windows we advertise are shifted right to fit in the header
+  uint8_t send_window_shift_ {}; // How far to shift the peer's advertised windows left
+
+  bool timestamps_ {}; // Whether both SYNs offered timestamps (RFC 7323)
+
+  // Delayed acks: in-order data is acked once two full segments' worth have arrived or the ack has waited
+  // cfg_.ack_delay, if no outgoing segment has carried it by then
+  uint64_t recv_mss_ {};      // Largest payload the peer has sent (up to the MSS we advertised)
+  uint64_t unacked_bytes_ {}; // Payload received since our last segment
+  bool ack_delayed_ {};       // Whether an ack is owed, but may wait
+  uint64_t ack_waited_ms_ {}; // How long it has waited
+
+  uint64_t idle_ms_ {};         // Time since either stream last moved a byte
+  uint64_t stream_activity_ {}; // Sum of both streams' byte counters as of the last tick
+
+  // Receive-buffer auto-tuning: once a round trip, the inbound stream's capacity may grow past cfg_.recv_capacity
+  // (as far as cfg_.recv_capacity_max, and what's left of the global budget, allow). It goes back when idle,
+  // as the peer uses up the window it was last given.
+  static inline std::atomic<uint64_t> autotuned_total_ {}; // What auto-tuning has added, over all connections
+  uint64_t autotuned_ {};                                  // What auto-tuning has added to this connection
+  uint64_t clock_ms_ {};                                   // Time since construction
+  uint64_t tune_start_ms_ {};                              // When the current round trip's measurement began
+  uint64_t tune_popped_ {};                                // Bytes the application had read by then
+  uint64_t advertised_edge_ {};                            // Stream index just past the last window advertised
+  bool returning_capacity_ {};                             // Whether the capacity is still going back
+
+  void tune_receive_capacity()
+  {
+    const auto srtt = sender_.rtt_estimator().srtt_ms();
+    if ( cfg_.max_recv_capacity() <= cfg_.recv_capacity or not srtt.has_value() ) {
+      return;
+    }
+    const double rtt = std::max( srtt.value(), 1.0 );
+    const uint64_t elapsed = clock_ms_ - tune_start_ms_;
+    if ( static_cast<double>( elapsed ) < rtt ) {
+      return;
+    }
+
+    // Leave room for twice what the application reads in a round trip, so that a sender it keeps up with isn't
+    // held back by the window (which then doubles each round trip, keeping ahead of slow start)
+    const uint64_t popped = inbound_stream_.reader().bytes_popped();
+    const double read_per_rtt = static_cast<double>( popped - tune_popped_ ) * rtt / static_cast<double>( elapsed );
+    tune_start_ms_ = clock_ms_;
+    tune_popped_ = popped;
+    const uint64_t wanted = std::min( static_cast<uint64_t>( 2 * read_per_rtt ), cfg_.max_recv_capacity() );
+    const uint64_t capacity = inbound_stream_.capacity();
+    if ( wanted <= capacity ) {
+      return;
+    }
+    returning_capacity_ = false;
+
+    uint64_t total = autotuned_total_.load();
+    uint64_t grant {};
+    do {
+      const uint64_t budget = TCPConfig::MAX_AUTOTUNED_TOTAL - std::min( total, TCPConfig::MAX_AUTOTUNED_TOTAL );
+      grant = std::min( wanted - capacity, budget );
+    } while ( not autotuned_total_.compare_exchange_weak( total, total + grant ) );
+    autotuned_ += grant;
+    inbound_stream_.set_capacity( capacity + grant );
+  }
+
+  // The capacity goes back no faster than the peer uses up the last window we advertised, whose right edge must
+  // not move back (RFC 9293 section 3.8.6). What's kept past cfg_.recv_capacity stays granted until it goes.
+  void return_autotuned_capacity()
+  {
+    const uint64_t popped = inbound_stream_.reader().bytes_popped();
+    const uint64_t promised = advertised_edge_ - std::min( advertised_edge_, popped );
+    inbound_stream_.set_capacity( std::max( cfg_.recv_capacity, promised ) );
+    const uint64_t kept = std::min( autotuned_, inbound_stream_.capacity() - cfg_.recv_capacity );
+    autotuned_total_ -= autotuned_ - kept;
+    autotuned_ = kept;
+    returning_capacity_ = autotuned_ > 0;
+  }
+
+  void release_memory_when_idle( uint64_t ms_since_last_tick )
+  {
+    const uint64_t activity = outbound_stream_.writer().bytes_pushed() + outbound_stream_.reader().bytes_popped()
+                              + inbound_stream_.writer().bytes_pushed() + inbound_stream_.reader().bytes_popped();
+    if ( activity != stream_activity_ ) {
+      stream_activity_ = activity;
+      idle_ms_ = 0;
+      return;
+    }
+
+    const bool was_idle = idle_ms_ >= cfg_.idle_shrink_ms;
+    idle_ms_ += ms_since_last_tick;
+    if ( not was_idle and idle_ms_ >= cfg_.idle_shrink_ms ) {
+      return_autotuned_capacity();
+      outbound_stream_.shrink_to_fit();
+      inbound_stream_.shrink_to_fit();
+    }
+  }
+
 public:
-  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) {}
+  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg )
+  {
+    // An ack may wait no longer than the peer's tail loss probe timeout allows for (RFC 8985 section 7.2)
+    cfg_.ack_delay = std::min( cfg_.ack_delay, TCPConfig::MAX_ACK_DELAY );
+    if ( cfg_.send_low_watermark.has_value() ) {
+      outbound_stream_.writer().set_low_watermark( cfg_.send_low_watermark.value() );
+    }
+  }
+
+  // It may hold part of the global auto-tuning budget, which it hands back when destroyed
+  ~TCPPeer() { autotuned_total_ -= autotuned_; }
+  TCPPeer( const TCPPeer& other ) = delete;
+  TCPPeer& operator=( const TCPPeer& other ) = delete;
 
   Writer& outbound_writer() { return outbound_stream_.writer(); }
   Reader& inbound_reader() { return inbound_stream_.reader(); }
 
   void push() { sender_.push( outbound_stream_.reader() ); };
-  void tick( uint64_t ms_since_last_tick ) { sender_.tick( ms_since_last_tick ); }
+  void tick( uint64_t ms_since_last_tick )
+  {
+    sender_.tick( ms_since_last_tick );
+    clock_ms_ += ms_since_last_tick;
+    tune_receive_capacity();
+    release_memory_when_idle( ms_since_last_tick );
+
+    if ( ack_delayed_ ) {
+      ack_waited_ms_ += ms_since_last_tick;
+      need_send_ |= ack_waited_ms_ >= cfg_.ack_delay;
+    }
+  }
+
+  // Hold back less-than-full segments until uncorked (the next maybe_send() pushes what was held)
+  void set_cork( bool cork ) { sender_.set_cork( cork ); }
+
+  // If the sender is pacing out data, how many milliseconds until it will send more?
+  std::optional<uint64_t> next_send_time() const { return sender_.next_send_time(); }
 
   bool has_ackno() const { return receiver_.send( inbound_stream_.writer() ).ackno.has_value(); }
 
@@ -47,22 +172,69 @@ public:
       return;
     }
 
+    // The peer's SYN limits the size of our segments (to 536 bytes, if it has no MSS option), and may agree to
+    // window scaling and timestamps.
+    const TCPSenderMessage& peer = seg.sender_message;
+    if ( peer.SYN ) {
+      sender_.set_peer_mss( peer.MSS.value_or( TCPConfig::DEFAULT_PEER_MSS ) );
+      sender_.set_peer_window_scale( peer.window_scale.has_value() );
+      if ( peer.window_scale.has_value() and cfg_.window_scaling ) {
+        send_window_shift_ = std::min( peer.window_scale.value(), TCPReceiverMessage::MAX_WINDOW_SHIFT );
+        recv_window_shift_ = TCPConfig::window_shift_for( cfg_.max_recv_capacity() );
+        receiver_.set_window_shift( recv_window_shift_ );
+      }
+      timestamps_ = cfg_.timestamps and peer.timestamp.has_value();
+      sender_.set_peer_timestamps( peer.timestamp.has_value() );
+    } else {
+      seg.receiver_message.window_size <<= send_window_shift_;
+    }
+    if ( not timestamps_ ) {
+      seg.sender_message.timestamp.reset();
+      seg.receiver_message.timestamp_echo.reset();
+    }
+
     // Give incoming TCPReceiverMessage to sender.
     sender_.receive( seg.receiver_message );
 
     // Give incoming TCPSenderMessage to receiver.
-    // If SenderMessage is non-empty or a keep-alive, make sure to reply.
-    need_send_ |= ( seg.sender_message.sequence_length() > 0 );
+    // If SenderMessage is a keep-alive, make sure to reply; if it's non-empty, to ack it (perhaps after a delay).
     const auto our_ackno = receiver_.send( inbound_stream_.writer() ).ackno;
     need_send_ |= ( our_ackno.has_value() and seg.sender_message.seqno + 1 == our_ackno.value() );
 
+    const Wrap32 seqno = seg.sender_message.seqno;
+    const uint64_t length = seg.sender_message.sequence_length();
+    const uint64_t payload_size = seg.sender_message.payload.size();
+    const bool urgent = seg.sender_message.SYN or seg.sender_message.FIN;
+    const bool gap_before = reassembler_.bytes_pending() > 0;
     receiver_.receive( std::move( seg.sender_message ), reassembler_, inbound_stream_.writer() );
+    if ( length == 0 ) {
+      return;
+    }
+
+    // Data that arrived out of order, or filled a gap (or was a duplicate), is acked at once, so the sender
+    // learns of the loss (or of its recovery) as soon as possible. So is a SYN or FIN.
+    const auto new_ackno = receiver_.send( inbound_stream_.writer() ).ackno;
+    const bool in_order = our_ackno.has_value() and seqno == our_ackno.value() and new_ackno.has_value()
+                          and new_ackno.value() == seqno + static_cast<uint32_t>( length ) and not gap_before;
+    const uint64_t our_mss = cfg_.mss.value_or( TCPConfig::MAX_PAYLOAD_SIZE );
+    recv_mss_ = std::max( recv_mss_, std::min( payload_size, our_mss ) );
+    unacked_bytes_ += payload_size;
+    if ( cfg_.ack_delay == 0 or urgent or not in_order or unacked_bytes_ >= 2 * recv_mss_ ) {
+      need_send_ = true;
+    } else {
+      ack_delayed_ = true;
+    }
   }
 
   std::optional<TCPSegment> maybe_send()
   {
-    // Get outgoing TCPReceiverMessage from receiver.
-    auto receiver_msg = receiver_.send( inbound_stream_.writer() );
+    if ( returning_capacity_ ) {
+      return_autotuned_capacity();
+    }
+
+    // Get outgoing TCPReceiverMessage from receiver (with SACK blocks, if both sides offered them).
+    auto receiver_msg = cfg_.sack ? receiver_.send( inbound_stream_.writer(), reassembler_ )
+                                  : receiver_.send( inbound_stream_.writer() );
 
     // If connection is alive, push stream to TCPSender.
     if ( receiver_msg.ackno.has_value() ) {
@@ -78,10 +250,26 @@ public:
 
     need_send_ = false;
 
-    // Send the segment
+    // Send the segment (any segment carries the ack, so nothing is owed after it)
     if ( sender_msg.has_value() ) {
-      return TCPSegment {
+      unacked_bytes_ = 0;
+      ack_delayed_ = false;
+      ack_waited_ms_ = 0;
+      if ( receiver_msg.ackno.has_value() ) {
+        receiver_.ack_sent( receiver_msg.ackno.value() );
+        advertised_edge_
+          = std::max( advertised_edge_, inbound_stream_.writer().bytes_pushed() + receiver_msg.window_size );
+      }
+      TCPSegment seg {
         sender_msg.value(), receiver_msg, outbound_stream_.reader().has_error() or inbound_reader().has_error() };
+      if ( not seg.sender_message.SYN ) {
+        seg.receiver_message.window_size >>= recv_window_shift_;
+      }
+      // A payload bigger than the MSS is a segmentation-offload burst, for the adapter to split
+      if ( seg.sender_message.payload.size() > sender_.mss() ) {
+        seg.segment_size = sender_.mss();
+      }
+      return seg;
     }
 
     return {};
@@ -91,4 +279,8 @@ public:
   const TCPReceiver& receiver() const { return receiver_; }
   const TCPSender& sender() const { return sender_; }
   const Reassembler& reassembler() const { return reassembler_; }
+  uint64_t memory_footprint() const
+  {
+    return outbound_stream_.memory_footprint() + inbound_stream_.memory_footprint();
+  }
 };
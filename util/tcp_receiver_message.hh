@@ -2,23 +2,51 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains two fields:
+ * It contains four fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
- *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    to receive, starting from the ackno if present. The header's window field holds at most 65,535
+ *    (UINT16_MAX from the <cstdint> header); with window scaling (RFC 7323), it holds the window
+ *    shifted right by the scale the peers agreed on, so the window can be as large as MAX_WINDOW.
+ *
+ * 3) Selective acknowledgments (RFC 2018), if the sender permitted them: ranges of sequence numbers
+ *    beyond the ackno that the TCP receiver already holds, the most recently changed first.
+ *
+ * 4) With timestamps (RFC 7323), the timestamp echo (TSecr): the TSval of the latest segment to arrive
+ *    in order, from which the sender can measure the round-trip time.
  */
 
+// Sequence numbers [left, right) have been received
+struct SACKBlock
+{
+  Wrap32 left;
+  Wrap32 right;
+
+  bool operator==( const SACKBlock& other ) const = default;
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4;    // As many as fit in the TCP header's option space
+  static constexpr size_t MAX_SACK_BLOCKS_TS = 3; // As many as fit alongside the timestamps option
+  static constexpr uint8_t MAX_WINDOW_SHIFT = 14; // RFC 7323's largest window scale
+
+  // The largest window that can be advertised (just under 1 GiB)
+  static constexpr uint32_t MAX_WINDOW = uint32_t { UINT16_MAX } << MAX_WINDOW_SHIFT;
+
   std::optional<Wrap32> ackno {};
-  uint16_t window_size {};
+  uint32_t window_size {};
+  std::vector<SACKBlock> sack {};
+  std::optional<uint32_t> timestamp_echo {};
 };
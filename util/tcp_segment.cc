@@ -2,12 +2,139 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
 
+// TCP option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNop = 1;
+static constexpr uint8_t TCPOptionMSS = 2;           // RFC 9293
+static constexpr uint8_t TCPOptionWindowScale = 3;   // RFC 7323
+static constexpr uint8_t TCPOptionSACKPermitted = 4; // RFC 2018
+static constexpr uint8_t TCPOptionSACK = 5;          // RFC 2018
+static constexpr uint8_t TCPOptionTimestamps = 8;    // RFC 7323
+
 using namespace std;
 
+namespace {
+
+// How many SACK blocks TCPSegment::serialize writes: as many as fit in the option space that's left
+size_t sack_blocks_sent( const TCPSegment& seg )
+{
+  const size_t max_blocks = seg.sender_message.timestamp.has_value() ? TCPReceiverMessage::MAX_SACK_BLOCKS_TS
+                                                                     : TCPReceiverMessage::MAX_SACK_BLOCKS;
+  return min( seg.receiver_message.sack.size(), max_blocks );
+}
+
+// Length, in bytes, of the options TCPSegment::serialize writes (padded to whole 32-bit words)
+size_t options_length( const TCPSegment& seg )
+{
+  size_t len = 0;
+  if ( seg.sender_message.SYN and seg.sender_message.MSS.has_value() ) {
+    len += 4;
+  }
+  if ( seg.sender_message.SYN and seg.sender_message.window_scale.has_value() ) {
+    len += 4;
+  }
+  if ( seg.sender_message.SYN and seg.sender_message.SACK_permitted ) {
+    len += 4;
+  }
+  if ( seg.sender_message.timestamp.has_value() ) {
+    len += 12;
+  }
+  const size_t sack_blocks = sack_blocks_sent( seg );
+  if ( sack_blocks > 0 ) {
+    len += 4 + 8 * sack_blocks;
+  }
+  return len;
+}
+
+} // namespace
+
+void TCPSegment::parse_options( Parser& parser, size_t len )
+{
+  while ( len > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    --len;
+    if ( kind == TCPOptionEnd ) {
+      break;
+    }
+    if ( kind == TCPOptionNop ) {
+      continue;
+    }
+
+    uint8_t option_len {};
+    parser.integer( option_len );
+    if ( option_len < 2 or option_len > len + 1 ) {
+      parser.set_error();
+      return;
+    }
+    size_t body_len = option_len - 2;
+    len -= option_len - 1;
+
+    switch ( kind ) {
+      case TCPOptionMSS:
+        if ( body_len != 2 ) {
+          parser.set_error();
+          return;
+        }
+        sender_message.MSS.emplace();
+        parser.integer( sender_message.MSS.value() );
+        body_len = 0;
+        break;
+      case TCPOptionWindowScale:
+        if ( body_len != 1 ) {
+          parser.set_error();
+          return;
+        }
+        sender_message.window_scale.emplace();
+        parser.integer( sender_message.window_scale.value() );
+        body_len = 0;
+        break;
+      case TCPOptionTimestamps: {
+        if ( body_len != 8 ) {
+          parser.set_error();
+          return;
+        }
+        uint32_t echo {};
+        sender_message.timestamp.emplace();
+        parser.integer( sender_message.timestamp.value() );
+        parser.integer( echo );
+        if ( receiver_message.ackno.has_value() ) {
+          receiver_message.timestamp_echo = echo; // Only meaningful with the ACK flag
+        }
+        body_len = 0;
+        break;
+      }
+      case TCPOptionSACKPermitted:
+        sender_message.SACK_permitted = true;
+        break;
+      case TCPOptionSACK:
+        if ( body_len % 8 != 0 ) {
+          parser.set_error();
+          return;
+        }
+        for ( ; body_len > 0; body_len -= 8 ) {
+          uint32_t left {};
+          uint32_t right {};
+          parser.integer( left );
+          parser.integer( right );
+          receiver_message.sack.push_back( { Wrap32 { left }, Wrap32 { right } } );
+        }
+        break;
+      default:
+        break;
+    }
+    parser.remove_prefix( body_len ); // whatever we didn't read
+  }
+
+  // skip any padding after the end-of-options marker
+  parser.remove_prefix( len );
+}
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   {
@@ -48,15 +175,16 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   sender_message.SYN = octet & 0b0000'0010;
   sender_message.FIN = octet & 0b0000'0001;
 
-  parser.integer( receiver_message.window_size );
+  parser.integer( raw16 );
+  receiver_message.window_size = raw16; // Unscaled: only the connection knows the window scale
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4 );
 
   parser.all_remaining( sender_message.payload );
 }
@@ -73,16 +201,62 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { sender_message.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { receiver_message.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  const size_t options_len = options_length( *this );
+  serializer.integer( static_cast<uint8_t>( ( TCPHeaderMinLen + options_len / 4 ) << 4 ) ); // data offset
   const uint8_t flags = ( receiver_message.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( sender_message.SYN ? 0b0000'0010U : 0 ) | ( sender_message.FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
-  serializer.integer( receiver_message.window_size );
+  // The connection scales windows down to fit (see TCPPeer), but a SYN's window is never scaled and may not fit
+  serializer.integer( static_cast<uint16_t>( min( receiver_message.window_size, uint32_t { UINT16_MAX } ) ) );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+
+  // options, each padded out to a word boundary with leading no-ops
+  if ( sender_message.SYN and sender_message.MSS.has_value() ) {
+    serializer.integer( TCPOptionMSS );
+    serializer.integer( uint8_t { 4 } );
+    serializer.integer( sender_message.MSS.value() );
+  }
+  if ( sender_message.SYN and sender_message.window_scale.has_value() ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionWindowScale );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( sender_message.window_scale.value() );
+  }
+  if ( sender_message.SYN and sender_message.SACK_permitted ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACKPermitted );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( sender_message.timestamp.has_value() ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionTimestamps );
+    serializer.integer( uint8_t { 10 } );
+    serializer.integer( sender_message.timestamp.value() );
+    serializer.integer( receiver_message.timestamp_echo.value_or( 0 ) );
+  }
+  const size_t sack_blocks = sack_blocks_sent( *this );
+  if ( sack_blocks > 0 ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACK );
+    serializer.integer( static_cast<uint8_t>( 2 + 8 * sack_blocks ) );
+    for ( size_t i = 0; i < sack_blocks; ++i ) {
+      serializer.integer( Wrap32Serializable { receiver_message.sack[i].left }.raw_value() );
+      serializer.integer( Wrap32Serializable { receiver_message.sack[i].right }.raw_value() );
+    }
+  }
+
   serializer.buffer( sender_message.payload );
 }
 
+size_t TCPSegment::header_length() const
+{
+  return TCPHeaderMinLen * 4 + options_length( *this );
+}
+
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
 {
   udinfo.cksum = 0;
@@ -12,8 +12,18 @@ struct TCPSegment
   bool reset {}; // Connection experienced an abnormal error and should be shut down
   UserDatagramInfo udinfo {};
 
+  // Segmentation offload (not part of the wire format): if nonzero, the payload is too big for one packet, and
+  // the adapter sends it as a run of segments carrying at most this many bytes each
+  size_t segment_size {};
+
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // Length of the serialized header, options included
+  size_t header_length() const;
+
+private:
+  void parse_options( Parser& parser, size_t len );
 };
@@ -3,12 +3,14 @@
 #include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains four fields:
+ * It contains eight fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -19,6 +21,16 @@
  * 3) The payload: a substring (possibly empty) of the byte stream.
  *
  * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * 5) On a SYN, whether the sender can make use of selective acknowledgments (the SACK-permitted option).
+ *
+ * 6) On a SYN, optionally, the largest payload the sender is willing to receive (the MSS option).
+ *
+ * 7) On a SYN, optionally, how far the sender will shift its advertised windows right to fit them in
+ *    the header (the window scale option). Windows are scaled only if both SYNs carry the option.
+ *
+ * 8) Optionally, the sender's clock when the segment was sent (TSval, from the timestamps option of
+ *    RFC 7323). Offered on the SYN, and sent on every segment once both SYNs have carried it.
  */
 
 struct TCPSenderMessage
@@ -27,6 +39,10 @@ struct TCPSenderMessage
   bool SYN { false };
   Buffer payload {};
   bool FIN { false };
+  bool SACK_permitted { false };
+  std::optional<uint16_t> MSS {};
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint32_t> timestamp {};
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
@@ -68,10 +68,19 @@ void TCPOverIPv4OverEthernetAdapter::tick( const size_t ms_since_last_tick )
   send_pending();
 }
 
+//! \param[in] cfg is the new configuration, whose MTU the NetworkInterface takes on
+void TCPOverIPv4OverEthernetAdapter::set_config( const FdAdapterConfig& cfg )
+{
+  TCPOverIPv4Adapter::set_config( cfg );
+  _interface.set_mtu( cfg.mtu );
+}
+
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write( TCPSegment& seg )
 {
-  _interface.send_datagram( wrap_tcp_in_ip( seg ), _next_hop );
+  for ( const auto& dgram : wrap_tcp_in_ip_segments( seg ) ) {
+    _interface.send_datagram( dgram, _next_hop );
+  }
   send_pending();
 }
 
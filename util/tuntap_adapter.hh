@@ -23,8 +23,14 @@ public:
   //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
   std::optional<TCPSegment> read();
 
-  //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-  void write( TCPSegment& seg ) { _tun.write( serialize( wrap_tcp_in_ip( seg ) ) ); }
+  //! Creates an IPv4 datagram from a TCP segment (or one per packet, for an offload burst) and writes it to the
+  //! TUN device
+  void write( TCPSegment& seg )
+  {
+    for ( const auto& dgram : wrap_tcp_in_ip_segments( seg ) ) {
+      _tun.write( serialize( dgram ) );
+    }
+  }
 
   //! Access the underlying TUN device
   explicit operator TunFD&() { return _tun; }
@@ -60,6 +66,9 @@ public:
   //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
   std::optional<TCPSegment> read();
 
+  //! Installs a new configuration, passing the link's MTU on to the NetworkInterface
+  void set_config( const FdAdapterConfig& cfg );
+
   //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
   void write( TCPSegment& seg );
 